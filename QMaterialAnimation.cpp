@@ -0,0 +1,90 @@
+#include "QMaterialAnimation.h"
+
+#include <QEasingCurve>
+#include <QLineF>
+#include <QPainter>
+
+void QMaterialElevationTransition::start(qreal current, qreal target)
+{
+    from = current;
+    to = target;
+    elapsedMs = 0.0;
+    running = true;
+}
+
+qreal QMaterialElevationTransition::advance(qreal dtMs)
+{
+    static const QEasingCurve easing(QEasingCurve::OutCubic);
+
+    elapsedMs += dtMs;
+    const qreal progress = qMin<qreal>(1.0, elapsedMs / durationMs);
+    if (progress >= 1.0)
+        running = false;
+
+    return from + (to - from) * easing.valueForProgress(progress);
+}
+
+void QMaterialRipple::start(const QPointF &pos, const QRectF &cardRect)
+{
+    center = pos;
+    radius = 0.0;
+    opacity = 1.0;
+
+    // Максимальный радиус — до самого дальнего угла
+    const qreal d1 = QLineF(center, cardRect.topLeft()).length();
+    const qreal d2 = QLineF(center, cardRect.topRight()).length();
+    const qreal d3 = QLineF(center, cardRect.bottomLeft()).length();
+    const qreal d4 = QLineF(center, cardRect.bottomRight()).length();
+
+    maxRadius = qMax(qMax(d1, d2), qMax(d3, d4));
+}
+
+bool QMaterialRipple::advance(qreal dtMs, int durationMs)
+{
+    if (opacity <= 0.0)
+        return false;
+
+    // Шаг по реально прошедшему времени
+    const qreal dt = dtMs / durationMs;
+    radius += maxRadius * dt;
+    opacity -= dt;
+
+    if (radius >= maxRadius) {
+        opacity -= dt * 2.0; // чуть быстрее затухаем в конце
+    }
+
+    if (opacity < 0.0) {
+        opacity = 0.0;
+    }
+
+    return opacity > 0.0;
+}
+
+QRect QMaterialRipple::boundingRect(const QRectF &cardRect) const
+{
+    if (opacity <= 0.0)
+        return QRect();
+
+    const qreal r = radius + 1.0; // запас на сглаживание
+    const QRectF disc(center.x() - r, center.y() - r, 2 * r, 2 * r);
+    return disc.toAlignedRect() & cardRect.toAlignedRect();
+}
+
+void QMaterialRipple::paint(QPainter &p, const QColor &color, QMaterialRippleRenderer renderer) const
+{
+    if (opacity <= 0.0)
+        return;
+
+    if (renderer != QMaterialRippleRenderer::Ellipse
+        && QMaterialRippleSprites::instance()->paint(p, center, radius, color, opacity,
+                                                     renderer == QMaterialRippleRenderer::SoftSprite)) {
+        return;
+    }
+
+    QColor c = color;
+    c.setAlphaF(c.alphaF() * opacity);
+
+    p.setPen(Qt::NoPen);
+    p.setBrush(c);
+    p.drawEllipse(center, radius, radius);
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "QMaterialRippleSprites.h"
+
+#include <QColor>
+#include <QPointF>
+#include <QRect>
+#include <QRectF>
+#include <QRegion>
+#include <QtGlobal>
+
+#include <array>
+
+class QPainter;
+
+// Переход elevation между состояниями (OutCubic).
+// Общий для QMaterialWidget и карточек в представлениях.
+struct QMaterialElevationTransition
+{
+    qreal from = 0.0;
+    qreal to = 0.0;
+    qreal elapsedMs = 0.0;
+    int durationMs = 150;
+    bool running = false;
+
+    void start(qreal current, qreal target);
+    void stop() { running = false; }
+
+    // Продвигает переход и возвращает текущее значение elevation
+    qreal advance(qreal dtMs);
+};
+
+// Один ripple: круг, растущий от точки нажатия до дальнего угла карточки
+struct QMaterialRipple
+{
+    QPointF center;
+    qreal radius = 0.0;
+    qreal maxRadius = 0.0;
+    qreal opacity = 0.0;
+
+    bool isActive() const { return opacity > 0.0; }
+
+    void start(const QPointF &pos, const QRectF &cardRect);
+    void clear() { opacity = 0.0; }
+
+    // Продвигает ripple; false — ripple затух
+    bool advance(qreal dtMs, int durationMs);
+
+    // Описанный квадрат, пересечённый с карточкой (для частичной перерисовки)
+    QRect boundingRect(const QRectF &cardRect) const;
+
+    // Рисует круг без отсечения: обрезку по карточке задаёт вызывающий код
+    void paint(QPainter &p, const QColor &color,
+               QMaterialRippleRenderer renderer = QMaterialRippleRenderer::Ellipse) const;
+};
+
+// Что делать с новым нажатием, когда все ячейки пула заняты
+enum class QMaterialRippleOverflow {
+    DropOldest,      // самый старый ripple исчезает, новый добавляется
+    ReplaceFaintest, // заменяется самый прозрачный (почти затухший) ripple
+    IgnoreNew        // новое нажатие не создаёт ripple
+};
+
+// Несколько одновременных ripple в массиве фиксированной ёмкости внутри объекта:
+// без выделений памяти в куче. Активные ripple лежат в начале массива от старого
+// к новому, затухшие вычищаются за тот же проход, что и продвижение.
+template <int Capacity>
+class QMaterialRipplePool
+{
+    static_assert(Capacity > 0, "QMaterialRipplePool needs at least one slot");
+
+public:
+    static constexpr int capacity() { return Capacity; }
+
+    int count() const { return m_count; }
+    bool isActive() const { return m_count > 0; }
+    bool isFull() const { return m_count == Capacity; }
+
+    const QMaterialRipple &at(int i) const { return m_ripples[i]; }
+
+    // Запускает новый ripple; false — пул полон и политика запрещает замену
+    bool start(const QPointF &pos, const QRectF &cardRect, QMaterialRippleOverflow policy)
+    {
+        if (isFull()) {
+            switch (policy) {
+            case QMaterialRippleOverflow::IgnoreNew:
+                return false;
+            case QMaterialRippleOverflow::DropOldest:
+                removeAt(0);
+                break;
+            case QMaterialRippleOverflow::ReplaceFaintest: {
+                int faintest = 0;
+                for (int i = 1; i < m_count; ++i) {
+                    if (m_ripples[i].opacity < m_ripples[faintest].opacity)
+                        faintest = i;
+                }
+                removeAt(faintest);
+                break;
+            }
+            }
+        }
+
+        m_ripples[m_count++].start(pos, cardRect);
+        return true;
+    }
+
+    void clear() { m_count = 0; }
+
+    // Продвигает все ripple одним проходом и уплотняет массив; false — все затухли
+    bool advance(qreal dtMs, int durationMs)
+    {
+        int alive = 0;
+        for (int i = 0; i < m_count; ++i) {
+            if (!m_ripples[i].advance(dtMs, durationMs))
+                continue;
+            if (alive != i)
+                m_ripples[alive] = m_ripples[i];
+            ++alive;
+        }
+        m_count = alive;
+        return m_count > 0;
+    }
+
+    // Объединение описанных квадратов всех ripple (для частичной перерисовки)
+    QRegion boundingRegion(const QRectF &cardRect) const
+    {
+        QRegion region;
+        for (int i = 0; i < m_count; ++i)
+            region += m_ripples[i].boundingRect(cardRect);
+        return region;
+    }
+
+    // Рисует все ripple от старого к новому; обрезку задаёт вызывающий код один раз
+    void paint(QPainter &p, const QColor &color,
+               QMaterialRippleRenderer renderer = QMaterialRippleRenderer::Ellipse) const
+    {
+        for (int i = 0; i < m_count; ++i)
+            m_ripples[i].paint(p, color, renderer);
+    }
+
+private:
+    void removeAt(int index)
+    {
+        for (int i = index + 1; i < m_count; ++i)
+            m_ripples[i - 1] = m_ripples[i];
+        --m_count;
+    }
+
+    std::array<QMaterialRipple, Capacity> m_ripples;
+    int m_count = 0;
+};
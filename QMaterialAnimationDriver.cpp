@@ -0,0 +1,83 @@
+#include "QMaterialAnimationDriver.h"
+
+#include <QCoreApplication>
+#include <QPointer>
+
+QMaterialAnimationDriver::QMaterialAnimationDriver(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setInterval(16); // ~60 FPS
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout,
+            this, &QMaterialAnimationDriver::tick);
+}
+
+QMaterialAnimationDriver *QMaterialAnimationDriver::instance()
+{
+    // Драйвер живёт вместе с приложением и пересоздаётся, если приложение создано заново
+    static QPointer<QMaterialAnimationDriver> driver;
+    if (!driver)
+        driver = new QMaterialAnimationDriver(QCoreApplication::instance());
+    return driver;
+}
+
+void QMaterialAnimationDriver::start(QMaterialAnimationTarget *target)
+{
+    if (!target)
+        return;
+
+    m_targets.insert(target);
+
+    if (!m_timer.isActive()) {
+        m_clock.start();
+        m_timer.start();
+    }
+}
+
+void QMaterialAnimationDriver::stop(QMaterialAnimationTarget *target)
+{
+    m_targets.remove(target);
+
+    if (m_targets.isEmpty())
+        m_timer.stop();
+}
+
+void QMaterialAnimationDriver::setFrameInterval(int ms)
+{
+    m_timer.setInterval(qMax(1, ms));
+}
+
+void QMaterialAnimationDriver::tick()
+{
+    // Реально прошедшее время, а не номинальный интервал таймера
+    const qreal dtMs = m_clock.nsecsElapsed() / 1e6;
+    m_clock.restart();
+
+    advance(dtMs);
+}
+
+void QMaterialAnimationDriver::resetStatistics()
+{
+    m_frameCount = 0;
+    m_activeMs = 0.0;
+}
+
+void QMaterialAnimationDriver::advance(qreal dtMs)
+{
+    ++m_frameCount;
+    m_activeMs += dtMs;
+
+    // Цели могут добавляться и удаляться прямо во время кадра (например, из слотов
+    // elevationChanged), поэтому обходим снимок и проверяем членство
+    const QList<QMaterialAnimationTarget *> targets = m_targets.values();
+    for (QMaterialAnimationTarget *target : targets) {
+        if (!m_targets.contains(target))
+            continue;
+
+        if (!target->advanceAnimations(dtMs))
+            m_targets.remove(target);
+    }
+
+    if (m_targets.isEmpty())
+        m_timer.stop();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QTimer>
+
+// Объект, анимации которого продвигает общий драйвер
+class QMaterialAnimationTarget
+{
+public:
+    virtual ~QMaterialAnimationTarget() = default;
+
+    // Продвигает все анимации объекта на dtMs миллисекунд реального времени.
+    // Возвращает false, если анимировать больше нечего.
+    virtual bool advanceAnimations(qreal dtMs) = 0;
+};
+
+// Общие для процесса часы анимаций: один таймер на все карточки.
+// Все активные ripple и переходы elevation продвигаются одной пачкой за кадр,
+// а без активных анимаций таймер полностью останавливается.
+class QMaterialAnimationDriver : public QObject
+{
+    Q_OBJECT
+
+public:
+    static QMaterialAnimationDriver *instance();
+
+    void start(QMaterialAnimationTarget *target);
+    void stop(QMaterialAnimationTarget *target);
+    bool isAnimating(QMaterialAnimationTarget *target) const { return m_targets.contains(target); }
+
+    // Есть ли хотя бы одна активная анимация (таймер запущен)
+    bool isActive() const { return m_timer.isActive(); }
+    int targetCount() const { return int(m_targets.size()); }
+
+    int frameInterval() const { return m_timer.interval(); }
+    void setFrameInterval(int ms);
+
+    // Продвигает все анимации на фиксированный шаг (для бенчмарков и стресс-тестов)
+    void advance(qreal dtMs);
+
+    // Счётчики кадров: число кадров и суммарное анимированное время
+    quint64 frameCount() const { return m_frameCount; }
+    qreal activeMs() const { return m_activeMs; }
+    void resetStatistics();
+
+private:
+    explicit QMaterialAnimationDriver(QObject *parent = nullptr);
+
+    void tick();
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    QSet<QMaterialAnimationTarget *> m_targets;
+    quint64 m_frameCount = 0;
+    qreal m_activeMs = 0.0;
+};
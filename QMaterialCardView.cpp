@@ -0,0 +1,88 @@
+#include "QMaterialCardView.h"
+
+QMaterialCardView::QMaterialCardView(QWidget *parent)
+    : QListView(parent),
+      m_delegate(new QMaterialItemDelegate(this)),
+      m_cardLayout(GridLayout),
+      m_cardSize(240, 120)
+{
+    // Карточки рисует делегат, он же хранит состояние hover, press и ripple
+    m_delegate->setCardMargins(QMargins(16, 16, 16, 16));
+    m_delegate->setContentMargins(QMargins(16, 12, 16, 12));
+    m_delegate->setCornerRadius(12.0);
+    m_delegate->setElevationStates(2.0, 6.0, 10.0);
+    setItemDelegate(m_delegate);
+
+    // Элементы одного размера: QListView считает раскладку без опроса каждого
+    // элемента и рисует только видимые
+    setUniformItemSizes(true);
+    setLayoutMode(QListView::Batched);
+    setBatchSize(1000);
+    setMovement(QListView::Static);
+    setResizeMode(QListView::Adjust);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setHorizontalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setFrameShape(QFrame::NoFrame);
+    setWordWrap(true);
+
+    applyCardLayout();
+    updateItemSize();
+}
+
+QMaterialCardView::~QMaterialCardView() = default;
+
+void QMaterialCardView::setCardLayout(CardLayout layout)
+{
+    if (m_cardLayout == layout)
+        return;
+
+    m_cardLayout = layout;
+    applyCardLayout();
+}
+
+void QMaterialCardView::applyCardLayout()
+{
+    if (m_cardLayout == GridLayout) {
+        setFlow(QListView::LeftToRight);
+        setWrapping(true);
+    } else {
+        setFlow(QListView::TopToBottom);
+        setWrapping(false);
+    }
+}
+
+void QMaterialCardView::setCardSize(const QSize &size)
+{
+    if (m_cardSize == size)
+        return;
+
+    m_cardSize = size;
+    updateItemSize();
+}
+
+void QMaterialCardView::setCardMargins(const QMargins &margins)
+{
+    if (m_delegate->cardMargins() == margins)
+        return;
+
+    m_delegate->setCardMargins(margins);
+    updateItemSize();
+}
+
+void QMaterialCardView::reset()
+{
+    m_delegate->clearState();
+    QListView::reset();
+}
+
+void QMaterialCardView::updateItemSize()
+{
+    // Все элементы одного размера: сетка задаётся явно, раскладка не опрашивает модель
+    const QMargins margins = m_delegate->cardMargins();
+    const QSize size(m_cardSize.width() + margins.left() + margins.right(),
+                     m_cardSize.height() + margins.top() + margins.bottom());
+
+    m_delegate->setFixedItemSize(size);
+    setGridSize(size);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "QMaterialItemDelegate.h"
+
+#include <QColor>
+#include <QListView>
+#include <QMargins>
+#include <QSize>
+
+// Виртуализированная сетка (или список) материальных карточек поверх
+// QAbstractItemModel. Выглядит как QMaterialWidget (тень, скругление, уровни
+// elevation, ripple), но не создаёт виджетов на элементы: рисуются только
+// видимые карточки, а состояние анимаций хранится лишь для тех элементов,
+// с которыми сейчас взаимодействуют.
+class QMaterialCardView : public QListView
+{
+    Q_OBJECT
+
+    Q_PROPERTY(CardLayout cardLayout READ cardLayout WRITE setCardLayout)
+    Q_PROPERTY(QSize cardSize READ cardSize WRITE setCardSize)
+    Q_PROPERTY(QMargins cardMargins READ cardMargins WRITE setCardMargins)
+    Q_PROPERTY(qreal cornerRadius READ cornerRadius WRITE setCornerRadius)
+    Q_PROPERTY(bool shadowEnabled READ isShadowEnabled WRITE setShadowEnabled)
+    Q_PROPERTY(qreal shadowIntensity READ shadowIntensity WRITE setShadowIntensity)
+    Q_PROPERTY(bool rippleEnabled READ isRippleEnabled WRITE setRippleEnabled)
+    Q_PROPERTY(QColor rippleColor READ rippleColor WRITE setRippleColor)
+
+public:
+    enum CardLayout {
+        GridLayout, // карточки слева направо с переносом строк
+        ListLayout  // одна колонка
+    };
+    Q_ENUM(CardLayout)
+
+    explicit QMaterialCardView(QWidget *parent = nullptr);
+    ~QMaterialCardView() override;
+
+    CardLayout cardLayout() const { return m_cardLayout; }
+    void setCardLayout(CardLayout layout);
+
+    // Размер самой карточки (без отступов под тень)
+    QSize cardSize() const { return m_cardSize; }
+    void setCardSize(const QSize &size);
+
+    // Отступы вокруг каждой карточки: в них рисуется тень
+    QMargins cardMargins() const { return m_delegate->cardMargins(); }
+    void setCardMargins(const QMargins &margins);
+
+    qreal cornerRadius() const { return m_delegate->cornerRadius(); }
+    void setCornerRadius(qreal r) { m_delegate->setCornerRadius(r); }
+
+    bool isShadowEnabled() const { return m_delegate->isShadowEnabled(); }
+    void setShadowEnabled(bool on) { m_delegate->setShadowEnabled(on); }
+
+    qreal shadowIntensity() const { return m_delegate->shadowIntensity(); }
+    void setShadowIntensity(qreal intensity) { m_delegate->setShadowIntensity(intensity); }
+
+    bool isRippleEnabled() const { return m_delegate->isRippleEnabled(); }
+    void setRippleEnabled(bool on) { m_delegate->setRippleEnabled(on); }
+
+    QColor rippleColor() const { return m_delegate->rippleColor(); }
+    void setRippleColor(const QColor &c) { m_delegate->setRippleColor(c); }
+
+    QMaterialRippleRenderer rippleRenderer() const { return m_delegate->rippleRenderer(); }
+    void setRippleRenderer(QMaterialRippleRenderer renderer) { m_delegate->setRippleRenderer(renderer); }
+
+    // Уровни elevation, как у QMaterialWidget
+    void setElevationStates(qreal rest, qreal hover, qreal pressed)
+    {
+        m_delegate->setElevationStates(rest, hover, pressed);
+    }
+    void setElevationStates(QMaterialElevationToken rest, QMaterialElevationToken hover,
+                            QMaterialElevationToken pressed)
+    {
+        m_delegate->setElevationStates(rest, hover, pressed);
+    }
+
+    // Делегат, который рисует карточки и хранит их состояние
+    QMaterialItemDelegate *cardDelegate() const { return m_delegate; }
+
+    // Число элементов, для которых сейчас хранится состояние
+    int activeCardCount() const { return m_delegate->activeCardCount(); }
+
+    void reset() override;
+
+private:
+    void updateItemSize();
+    void applyCardLayout();
+
+    QMaterialItemDelegate *m_delegate;
+
+    CardLayout m_cardLayout;
+    QSize m_cardSize;
+};
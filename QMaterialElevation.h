@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QMargins>
+#include <QtGlobal>
+
+#include <array>
+
+// Стандартные уровни elevation Material Design. Значение — высота в dp,
+// она же elevation карточки.
+enum class QMaterialElevationToken : int {
+    Level0 = 0,
+    Level1 = 1,
+    Level2 = 2,
+    Level3 = 3,
+    Level4 = 4,
+    Level6 = 6,
+    Level8 = 8,
+    Level9 = 9,
+    Level12 = 12,
+    Level16 = 16,
+    Level24 = 24
+};
+
+// Уровень таблицы с отступами под его тень, посчитанными при компиляции.
+// Смещение, размытие и прозрачность тени здесь не хранятся: их по тем же
+// формулам считает QMaterialShadowSpec, и только при растеризации (промахе кэша).
+struct QMaterialElevationLevel
+{
+    int dp;
+    QMargins margins; // самые узкие отступы, в которые помещается тень
+};
+
+namespace QMaterialElevation {
+
+// Геометрия тени от elevation (её же использует QMaterialShadowSpec)
+constexpr qreal yOffset(qreal elevation) { return elevation * 0.4; }
+constexpr qreal blurRadius(qreal elevation) { return 2.0 + elevation * 1.5; }
+constexpr int alpha(qreal elevation) { return qBound(20, int(25 + elevation * 6), 130); }
+
+constexpr int ceilPositive(qreal value)
+{
+    return qreal(int(value)) < value ? int(value) + 1 : int(value);
+}
+
+// Отступы под тень: размытие, смещение вниз (сверху тень короче, снизу длиннее)
+// и пиксель на сглаживание
+constexpr QMargins shadowMargins(qreal elevation)
+{
+    return elevation <= 0.0
+        ? QMargins()
+        : QMargins(ceilPositive(blurRadius(elevation)) + 1,
+                   (blurRadius(elevation) > yOffset(elevation)
+                        ? ceilPositive(blurRadius(elevation) - yOffset(elevation)) : 0) + 1,
+                   ceilPositive(blurRadius(elevation)) + 1,
+                   ceilPositive(blurRadius(elevation) + yOffset(elevation)) + 1);
+}
+
+constexpr QMaterialElevationLevel makeLevel(QMaterialElevationToken token)
+{
+    return QMaterialElevationLevel{int(token), shadowMargins(int(token))};
+}
+
+constexpr std::array<QMaterialElevationLevel, 11> Levels = {{
+    makeLevel(QMaterialElevationToken::Level0),
+    makeLevel(QMaterialElevationToken::Level1),
+    makeLevel(QMaterialElevationToken::Level2),
+    makeLevel(QMaterialElevationToken::Level3),
+    makeLevel(QMaterialElevationToken::Level4),
+    makeLevel(QMaterialElevationToken::Level6),
+    makeLevel(QMaterialElevationToken::Level8),
+    makeLevel(QMaterialElevationToken::Level9),
+    makeLevel(QMaterialElevationToken::Level12),
+    makeLevel(QMaterialElevationToken::Level16),
+    makeLevel(QMaterialElevationToken::Level24),
+}};
+
+constexpr int indexOf(int dp)
+{
+    for (int i = 0; i < int(Levels.size()); ++i) {
+        if (Levels[i].dp == dp)
+            return i;
+    }
+    return -1;
+}
+
+constexpr const QMaterialElevationLevel &level(QMaterialElevationToken token)
+{
+    // Токен вне перечисления (например, QMaterialElevationToken(5)) — ошибка
+    // вызова; без отладочной проверки берётся уровень 0, а не память до таблицы
+    const int index = indexOf(int(token));
+    Q_ASSERT_X(index >= 0, "QMaterialElevation::level", "not a standard elevation level");
+    return Levels[index < 0 ? 0 : index];
+}
+
+constexpr qreal elevation(QMaterialElevationToken token)
+{
+    return qreal(int(token));
+}
+
+// Уровень таблицы, которому в точности равен elevation, иначе nullptr
+inline const QMaterialElevationLevel *find(qreal elevation)
+{
+    const int dp = qRound(elevation);
+    if (!qFuzzyCompare(elevation + 1.0, dp + 1.0))
+        return nullptr;
+
+    const int index = indexOf(dp);
+    return index < 0 ? nullptr : &Levels[index];
+}
+
+static_assert(level(QMaterialElevationToken::Level24).dp == 24, "elevation table is out of order");
+static_assert(level(QMaterialElevationToken::Level0).margins.isNull(), "level 0 casts no shadow");
+
+} // namespace QMaterialElevation
@@ -0,0 +1,484 @@
+#include "QMaterialItemDelegate.h"
+#include "QMaterialShadowCache.h"
+
+#include <QAbstractItemView>
+#include <QApplication>
+#include <QCursor>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPainterPath>
+#include <QScrollBar>
+#include <QtMath>
+
+QMaterialItemDelegate::QMaterialItemDelegate(QAbstractItemView *view)
+    : QStyledItemDelegate(view),
+      m_view(view),
+      m_cardScope(ItemCard),
+      m_cardMargins(8, 6, 8, 6),
+      m_contentMargins(12, 8, 12, 8),
+      m_cornerRadius(8.0),
+      m_shadowEnabled(true),
+      m_shadowIntensity(1.0),
+      m_rippleEnabled(true),
+      m_rippleColor(0, 0, 0, 80),
+      m_rippleRenderer(QMaterialRippleRenderer::Ellipse),
+      m_rippleDurationMs(250),
+      m_restElevation(1.0),
+      m_hoverElevation(4.0),
+      m_pressedElevation(8.0)
+{
+    if (!m_view)
+        return;
+
+    // Hover отслеживаем сами: движения мыши без нажатия представление делегату не передаёт
+    m_view->viewport()->setMouseTracking(true);
+    m_view->viewport()->installEventFilter(this);
+
+    // При прокрутке колесом карточка под курсором меняется без движения мыши
+    connect(m_view->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &QMaterialItemDelegate::updateHoverFromCursor);
+    connect(m_view->horizontalScrollBar(), &QScrollBar::valueChanged,
+            this, &QMaterialItemDelegate::updateHoverFromCursor);
+}
+
+QMaterialItemDelegate::~QMaterialItemDelegate()
+{
+    QMaterialAnimationDriver::instance()->stop(this);
+}
+
+void QMaterialItemDelegate::setCardScope(CardScope scope)
+{
+    if (m_cardScope == scope)
+        return;
+
+    m_cardScope = scope;
+    clearState();
+}
+
+void QMaterialItemDelegate::setCardMargins(const QMargins &margins)
+{
+    if (m_cardMargins == margins)
+        return;
+
+    m_cardMargins = margins;
+    emit sizeHintChanged(QModelIndex());
+    if (m_view)
+        m_view->viewport()->update();
+}
+
+void QMaterialItemDelegate::setContentMargins(const QMargins &margins)
+{
+    if (m_contentMargins == margins)
+        return;
+
+    m_contentMargins = margins;
+    emit sizeHintChanged(QModelIndex());
+    if (m_view)
+        m_view->viewport()->update();
+}
+
+void QMaterialItemDelegate::setFixedItemSize(const QSize &size)
+{
+    if (m_fixedItemSize == size)
+        return;
+
+    m_fixedItemSize = size;
+    emit sizeHintChanged(QModelIndex());
+}
+
+void QMaterialItemDelegate::setCornerRadius(qreal r)
+{
+    if (qFuzzyCompare(m_cornerRadius, r))
+        return;
+
+    m_cornerRadius = r;
+    if (m_view)
+        m_view->viewport()->update();
+}
+
+void QMaterialItemDelegate::setShadowEnabled(bool on)
+{
+    if (m_shadowEnabled == on)
+        return;
+
+    m_shadowEnabled = on;
+    if (m_view)
+        m_view->viewport()->update();
+}
+
+void QMaterialItemDelegate::setShadowIntensity(qreal intensity)
+{
+    intensity = qBound(0.0, intensity, 1.0);
+    if (qFuzzyCompare(m_shadowIntensity, intensity))
+        return;
+
+    m_shadowIntensity = intensity;
+    if (m_view)
+        m_view->viewport()->update();
+}
+
+void QMaterialItemDelegate::setRippleEnabled(bool on)
+{
+    if (m_rippleEnabled == on)
+        return;
+
+    m_rippleEnabled = on;
+    if (!m_rippleEnabled) {
+        for (CardState &state : m_states)
+            state.ripple.clear();
+        if (m_view)
+            m_view->viewport()->update();
+    }
+}
+
+void QMaterialItemDelegate::setElevationStates(qreal rest, qreal hover, qreal pressed)
+{
+    m_restElevation = rest;
+    m_hoverElevation = hover;
+    m_pressedElevation = pressed;
+
+    // Карточки в покое не хранят состояния и сразу получат новый уровень
+    if (m_view)
+        m_view->viewport()->update();
+}
+
+void QMaterialItemDelegate::clearState()
+{
+    m_states.clear();
+    m_hoveredIndex = QPersistentModelIndex();
+    m_pressedIndex = QPersistentModelIndex();
+    QMaterialAnimationDriver::instance()->stop(this);
+
+    if (m_view)
+        m_view->viewport()->update();
+}
+
+QSize QMaterialItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    if (m_fixedItemSize.isValid())
+        return m_fixedItemSize;
+
+    const QSize content = QStyledItemDelegate::sizeHint(option, index);
+    const int horizontal = m_cardMargins.left() + m_cardMargins.right()
+                           + m_contentMargins.left() + m_contentMargins.right();
+    const int vertical = m_cardMargins.top() + m_cardMargins.bottom()
+                         + m_contentMargins.top() + m_contentMargins.bottom();
+
+    // В режиме строки горизонтальные отступы приходятся только на крайние колонки
+    if (m_cardScope == RowCard)
+        return QSize(content.width(), content.height() + vertical);
+
+    return QSize(content.width() + horizontal, content.height() + vertical);
+}
+
+void QMaterialItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                                  const QModelIndex &index) const
+{
+    const QModelIndex key = cardIndex(index);
+    const QRect item = m_cardScope == RowCard ? cardItemRect(index) : option.rect;
+    const QRectF card = cardRect(item);
+    if (card.isEmpty())
+        return;
+
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+
+    // Одна выборка состояния на элемент: и для elevation, и для ripple
+    const CardState *state = findState(key);
+    const qreal elevation = state ? state->elevation : m_restElevation;
+    const QMaterialRipple *ripple = m_rippleEnabled && state && state->ripple.isActive()
+        ? &state->ripple : nullptr;
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, true);
+
+    // Карточка строки рисуется по частям: каждая ячейка — только в своей полосе.
+    // Тень может выходить за отступы элемента: полоса продлевается на неё
+    // сверху и снизу, а у крайних ячеек — и в сторону края строки.
+    if (m_cardScope == RowCard) {
+        const QMargins extent = shadowExtent();
+        painter->setClipRect(option.rect.adjusted(
+            option.rect.left() <= item.left() ? -extent.left() : 0, -extent.top(),
+            option.rect.right() >= item.right() ? extent.right() : 0, extent.bottom()));
+    }
+
+    // 1) Тень. Карточки элементов одного размера делят записи кэша, а ширина
+    //    строк меняется вместе с колонками, поэтому для них — nine-patch
+    if (m_shadowEnabled && elevation > 0.0) {
+        QMaterialShadowSpec spec;
+        spec.cornerRadius = m_cornerRadius;
+        spec.elevation = elevation;
+        spec.intensity = m_shadowIntensity;
+        if (m_cardScope == RowCard)
+            QMaterialShadowCache::instance()->paintNinePatchShadow(*painter, card, spec);
+        else
+            QMaterialShadowCache::instance()->paintShadow(*painter, card, spec);
+    }
+
+    // 2) Фон: BackgroundRole модели, иначе Base (или AlternateBase) из палитры
+    QBrush background = opt.backgroundBrush;
+    if (background.style() == Qt::NoBrush) {
+        background = (opt.features & QStyleOptionViewItem::Alternate)
+                         ? opt.palette.alternateBase()
+                         : opt.palette.base();
+    }
+
+    QPainterPath clip;
+    clip.addRoundedRect(card, m_cornerRadius, m_cornerRadius);
+
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(background);
+    painter->drawPath(clip);
+
+    // 3) Ripple поверх фона. Пока круг не задевает скруглённые углы, его
+    //    обрезает прямоугольник карточки: отсечение путём со сглаживанием
+    //    стоит дороже самого круга, особенно спрайтового
+    if (ripple) {
+        painter->save();
+        painter->translate(card.topLeft());
+        const QRectF local(QPointF(0, 0), card.size());
+        const QRect pixels = local.toAlignedRect();
+        const QRect bounds = ripple->boundingRect(local);
+        const int corner = qCeil(m_cornerRadius);
+        if (corner > 0 && !pixels.adjusted(corner, 0, -corner, 0).contains(bounds)
+                && !pixels.adjusted(0, corner, 0, -corner).contains(bounds))
+            painter->setClipPath(clip.translated(-card.topLeft()), Qt::IntersectClip);
+        else
+            painter->setClipRect(local, Qt::IntersectClip);
+        ripple->paint(*painter, m_rippleColor, m_rippleRenderer);
+        painter->restore();
+    }
+
+    if (opt.state & QStyle::State_Selected) {
+        painter->setPen(QPen(opt.palette.highlight(), 2.0));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRoundedRect(card.adjusted(1, 1, -1, -1), m_cornerRadius, m_cornerRadius);
+    }
+
+    painter->restore();
+
+    // 4) Содержимое рисует стиль, как у обычного делегата, но без собственной
+    //    подложки: выделение и hover уже показаны карточкой
+    opt.rect = option.rect & card.toRect().marginsRemoved(m_contentMargins);
+    opt.state &= ~(QStyle::State_Selected | QStyle::State_MouseOver | QStyle::State_HasFocus);
+    opt.backgroundBrush = QBrush();
+    opt.features &= ~QStyleOptionViewItem::Alternate;
+
+    const QWidget *widget = option.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+}
+
+bool QMaterialItemDelegate::eventFilter(QObject *watched, QEvent *event)
+{
+    if (!m_view || watched != m_view->viewport())
+        return QStyledItemDelegate::eventFilter(watched, event);
+
+    switch (event->type()) {
+    case QEvent::MouseMove: {
+        const QMouseEvent *mouse = static_cast<QMouseEvent *>(event);
+        setHoveredIndex(cardIndex(m_view->indexAt(mouse->pos())));
+        break;
+    }
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonDblClick: {
+        const QMouseEvent *mouse = static_cast<QMouseEvent *>(event);
+        if (mouse->button() == Qt::LeftButton)
+            mousePress(mouse->pos());
+        break;
+    }
+    case QEvent::MouseButtonRelease:
+        if (static_cast<QMouseEvent *>(event)->button() == Qt::LeftButton)
+            mouseRelease();
+        break;
+    case QEvent::Leave:
+        setHoveredIndex(QModelIndex());
+        break;
+    default:
+        break;
+    }
+
+    // Событие дальше обрабатывает само представление
+    return false;
+}
+
+QModelIndex QMaterialItemDelegate::cardIndex(const QModelIndex &index) const
+{
+    if (m_cardScope == RowCard && index.isValid())
+        return index.sibling(index.row(), 0);
+    return index;
+}
+
+QRect QMaterialItemDelegate::cardItemRect(const QModelIndex &index) const
+{
+    if (!m_view || !index.isValid())
+        return QRect();
+
+    if (m_cardScope == ItemCard)
+        return m_view->visualRect(index);
+
+    // Строка — объединение ячеек всех видимых колонок (у скрытых прямоугольник пустой)
+    QRect rect;
+    const int columns = index.model()->columnCount(index.parent());
+    for (int column = 0; column < columns; ++column)
+        rect |= m_view->visualRect(index.sibling(index.row(), column));
+    return rect;
+}
+
+QRectF QMaterialItemDelegate::cardRect(const QRect &itemRect) const
+{
+    return QRectF(itemRect.marginsRemoved(m_cardMargins));
+}
+
+const QMaterialItemDelegate::CardState *QMaterialItemDelegate::findState(const QModelIndex &key) const
+{
+    // Пустой хэш — обычный случай: не строим QPersistentModelIndex зря
+    if (m_states.isEmpty())
+        return nullptr;
+
+    const auto it = m_states.constFind(QPersistentModelIndex(key));
+    return it != m_states.constEnd() ? &*it : nullptr;
+}
+
+QMargins QMaterialItemDelegate::shadowExtent() const
+{
+    if (!m_shadowEnabled)
+        return QMargins();
+
+    QMaterialShadowSpec spec;
+    spec.cornerRadius = m_cornerRadius;
+    spec.elevation = qMax(m_restElevation, qMax(m_hoverElevation, m_pressedElevation));
+    if (spec.elevation <= 0.0)
+        return QMargins();
+
+    return QMaterialShadowCache::shadowExtent(spec);
+}
+
+QMaterialItemDelegate::CardState &QMaterialItemDelegate::cardState(const QModelIndex &key)
+{
+    const QPersistentModelIndex persistent(key);
+    auto it = m_states.find(persistent);
+    if (it == m_states.end()) {
+        CardState state;
+        state.elevation = m_restElevation;
+        it = m_states.insert(persistent, state);
+    }
+    return *it;
+}
+
+void QMaterialItemDelegate::setTargetElevation(const QModelIndex &key, qreal target)
+{
+    if (!key.isValid())
+        return;
+
+    CardState &state = cardState(key);
+    state.transition.start(state.elevation, target);
+    QMaterialAnimationDriver::instance()->start(this);
+}
+
+void QMaterialItemDelegate::setHoveredIndex(const QModelIndex &key)
+{
+    if (m_hoveredIndex == key)
+        return;
+
+    // Нажатая карточка остаётся на уровне pressed до отпускания
+    if (m_hoveredIndex.isValid() && m_hoveredIndex != m_pressedIndex)
+        setTargetElevation(m_hoveredIndex, m_restElevation);
+
+    m_hoveredIndex = key;
+
+    if (m_hoveredIndex.isValid() && m_hoveredIndex != m_pressedIndex)
+        setTargetElevation(m_hoveredIndex, m_hoverElevation);
+}
+
+void QMaterialItemDelegate::updateHoverFromCursor()
+{
+    if (!m_view || !m_view->viewport()->underMouse())
+        return;
+
+    const QPoint pos = m_view->viewport()->mapFromGlobal(QCursor::pos());
+    setHoveredIndex(cardIndex(m_view->indexAt(pos)));
+}
+
+void QMaterialItemDelegate::updateCard(const QModelIndex &key)
+{
+    if (!m_view)
+        return;
+
+    // Тень высоких уровней шире отступов элемента и ложится на соседей:
+    // они попадут в область перерисовки и нарисуются заново вместе с ней
+    const QRect item = cardItemRect(key);
+    const QRect shadow = cardRect(item).toAlignedRect().marginsAdded(shadowExtent());
+    m_view->viewport()->update(item | shadow);
+}
+
+void QMaterialItemDelegate::mousePress(const QPoint &pos)
+{
+    const QModelIndex key = cardIndex(m_view->indexAt(pos));
+    m_pressedIndex = key;
+    if (!key.isValid())
+        return;
+
+    setTargetElevation(key, m_pressedElevation);
+
+    const QRectF card = cardRect(cardItemRect(key));
+    if (m_rippleEnabled && card.contains(pos)) {
+        // Ripple хранится в координатах карточки, чтобы не зависеть от прокрутки
+        cardState(key).ripple.start(pos - card.topLeft(), QRectF(QPointF(0, 0), card.size()));
+        QMaterialAnimationDriver::instance()->start(this);
+    }
+}
+
+void QMaterialItemDelegate::mouseRelease()
+{
+    const QModelIndex pressed = m_pressedIndex;
+    m_pressedIndex = QPersistentModelIndex();
+
+    if (pressed.isValid()) {
+        // Если курсор всё ещё над карточкой — вернёмся к hover
+        setTargetElevation(pressed, pressed == m_hoveredIndex ? m_hoverElevation : m_restElevation);
+    }
+}
+
+bool QMaterialItemDelegate::advanceAnimations(qreal dtMs)
+{
+    bool animating = false;
+
+    for (auto it = m_states.begin(); it != m_states.end();) {
+        // Элемент удалён из модели
+        if (!it.key().isValid()) {
+            it = m_states.erase(it);
+            continue;
+        }
+
+        CardState &state = it.value();
+        bool changed = false;
+
+        if (state.transition.running) {
+            state.elevation = state.transition.advance(dtMs);
+            changed = true;
+        }
+
+        if (state.ripple.isActive()) {
+            state.ripple.advance(dtMs, m_rippleDurationMs);
+            changed = true;
+        }
+
+        if (changed)
+            updateCard(it.key());
+
+        const bool busy = state.transition.running || state.ripple.isActive();
+        animating = animating || busy;
+
+        // Карточка вернулась в покой: состояние больше не нужно
+        if (!busy && it.key() != m_hoveredIndex && it.key() != m_pressedIndex
+                && qFuzzyCompare(state.elevation, m_restElevation)) {
+            it = m_states.erase(it);
+            continue;
+        }
+
+        ++it;
+    }
+
+    return animating;
+}
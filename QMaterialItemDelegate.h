@@ -0,0 +1,160 @@
+#pragma once
+
+#include "QMaterialAnimation.h"
+#include "QMaterialAnimationDriver.h"
+#include "QMaterialElevation.h"
+
+#include <QColor>
+#include <QHash>
+#include <QMargins>
+#include <QPersistentModelIndex>
+#include <QPointer>
+#include <QStyledItemDelegate>
+
+class QAbstractItemView;
+
+// Делегат, рисующий элементы существующих представлений (QListView, QTableView,
+// QTreeView) как материальные карточки: тень из общего кэша, скруглённый фон,
+// ripple и уровни elevation для hover и press. Состояние хранится в самом
+// делегате по индексу и только для элементов, с которыми сейчас взаимодействуют,
+// поэтому тысячи строк не требуют ни одного QObject на строку.
+// Фон карточки берётся из BackgroundRole модели, иначе из палитры (Base или
+// AlternateBase); правила styleSheet для элементов (::item) к нему не применяются.
+class QMaterialItemDelegate : public QStyledItemDelegate, public QMaterialAnimationTarget
+{
+    Q_OBJECT
+
+    Q_PROPERTY(CardScope cardScope READ cardScope WRITE setCardScope)
+    Q_PROPERTY(QMargins cardMargins READ cardMargins WRITE setCardMargins)
+    Q_PROPERTY(QMargins contentMargins READ contentMargins WRITE setContentMargins)
+    Q_PROPERTY(qreal cornerRadius READ cornerRadius WRITE setCornerRadius)
+    Q_PROPERTY(bool shadowEnabled READ isShadowEnabled WRITE setShadowEnabled)
+    Q_PROPERTY(qreal shadowIntensity READ shadowIntensity WRITE setShadowIntensity)
+    Q_PROPERTY(bool rippleEnabled READ isRippleEnabled WRITE setRippleEnabled)
+    Q_PROPERTY(QColor rippleColor READ rippleColor WRITE setRippleColor)
+
+public:
+    // Что считается одной карточкой
+    enum CardScope {
+        ItemCard, // каждый элемент — отдельная карточка
+        RowCard   // вся строка (все колонки) — одна карточка, как в QTableView
+    };
+    Q_ENUM(CardScope)
+
+    // Делегат следит за мышью во viewport представления и перерисовывает
+    // только прямоугольники анимируемых карточек
+    explicit QMaterialItemDelegate(QAbstractItemView *view);
+    ~QMaterialItemDelegate() override;
+
+    QAbstractItemView *view() const { return m_view; }
+
+    CardScope cardScope() const { return m_cardScope; }
+    void setCardScope(CardScope scope);
+
+    // Отступы вокруг карточки внутри прямоугольника элемента: в них рисуется тень
+    QMargins cardMargins() const { return m_cardMargins; }
+    void setCardMargins(const QMargins &margins);
+
+    // Отступы содержимого (иконка, текст) от края карточки
+    QMargins contentMargins() const { return m_contentMargins; }
+    void setContentMargins(const QMargins &margins);
+
+    // Фиксированный размер элемента вместе с отступами (например, для сетки
+    // карточек). Недействительный размер — размер по содержимому.
+    QSize fixedItemSize() const { return m_fixedItemSize; }
+    void setFixedItemSize(const QSize &size);
+
+    qreal cornerRadius() const { return m_cornerRadius; }
+    void setCornerRadius(qreal r);
+
+    bool isShadowEnabled() const { return m_shadowEnabled; }
+    void setShadowEnabled(bool on);
+
+    qreal shadowIntensity() const { return m_shadowIntensity; }
+    void setShadowIntensity(qreal intensity);
+
+    bool isRippleEnabled() const { return m_rippleEnabled; }
+    void setRippleEnabled(bool on);
+
+    QColor rippleColor() const { return m_rippleColor; }
+    void setRippleColor(const QColor &c) { m_rippleColor = c; }
+
+    // Способ рисования ripple, как у QMaterialWidget::rippleRenderer
+    QMaterialRippleRenderer rippleRenderer() const { return m_rippleRenderer; }
+    void setRippleRenderer(QMaterialRippleRenderer renderer) { m_rippleRenderer = renderer; }
+
+    // Уровни elevation, как у QMaterialWidget
+    void setElevationStates(qreal rest, qreal hover, qreal pressed);
+    void setElevationStates(QMaterialElevationToken rest, QMaterialElevationToken hover,
+                            QMaterialElevationToken pressed)
+    {
+        setElevationStates(QMaterialElevation::elevation(rest), QMaterialElevation::elevation(hover),
+                           QMaterialElevation::elevation(pressed));
+    }
+
+    // Число карточек, для которых сейчас хранится состояние
+    int activeCardCount() const { return int(m_states.size()); }
+
+    // Сбрасывает состояние всех карточек (например, при смене модели)
+    void clearState();
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    // Состояние карточки, с которой взаимодействуют
+    struct CardState
+    {
+        qreal elevation = 0.0;
+        QMaterialElevationTransition transition;
+        QMaterialRipple ripple; // в координатах карточки
+    };
+
+    bool advanceAnimations(qreal dtMs) override;
+
+    // Индекс, по которому хранится состояние карточки (для RowCard — колонка 0)
+    QModelIndex cardIndex(const QModelIndex &index) const;
+    // Прямоугольник всей карточки вместе с отступами под тень, в координатах viewport
+    QRect cardItemRect(const QModelIndex &index) const;
+    QRectF cardRect(const QRect &itemRect) const;
+
+    // Состояние карточки или nullptr, если с ней не взаимодействуют
+    const CardState *findState(const QModelIndex &key) const;
+    // Насколько тень наибольшего уровня выходит за карточку
+    QMargins shadowExtent() const;
+
+    CardState &cardState(const QModelIndex &key);
+    void setTargetElevation(const QModelIndex &key, qreal target);
+    void setHoveredIndex(const QModelIndex &key);
+    void updateHoverFromCursor();
+    void updateCard(const QModelIndex &key);
+
+    void mousePress(const QPoint &pos);
+    void mouseRelease();
+
+    QPointer<QAbstractItemView> m_view;
+
+    QHash<QPersistentModelIndex, CardState> m_states;
+    QPersistentModelIndex m_hoveredIndex;
+    QPersistentModelIndex m_pressedIndex;
+
+    CardScope m_cardScope;
+    QMargins m_cardMargins;
+    QMargins m_contentMargins;
+    QSize m_fixedItemSize;
+    qreal m_cornerRadius;
+    bool m_shadowEnabled;
+    qreal m_shadowIntensity;
+    bool m_rippleEnabled;
+    QColor m_rippleColor;
+    QMaterialRippleRenderer m_rippleRenderer;
+    int m_rippleDurationMs;
+
+    qreal m_restElevation;
+    qreal m_hoverElevation;
+    qreal m_pressedElevation;
+};
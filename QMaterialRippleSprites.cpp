@@ -0,0 +1,120 @@
+#include "QMaterialRippleSprites.h"
+
+#include <QCoreApplication>
+#include <QPainter>
+#include <QPaintDevice>
+#include <QRadialGradient>
+
+namespace {
+
+// Бюджет: все корзины до MaxSpriteSize для нескольких цветов
+constexpr int MaxCostKb = 16 * 1024;
+
+Q_GLOBAL_STATIC(QMaterialRippleSprites, s_rippleSprites)
+
+void clearRippleSprites()
+{
+    // Пиксмапы должны быть освобождены до разрушения QGuiApplication
+    if (s_rippleSprites.exists())
+        s_rippleSprites()->clear();
+}
+
+quint64 spriteKey(const QColor &color, int size, bool soft)
+{
+    return (quint64(color.rgba()) << 32) | (quint64(size) << 1) | quint64(soft);
+}
+
+} // namespace
+
+QMaterialRippleSprites::QMaterialRippleSprites()
+    : m_cache(MaxCostKb)
+{
+}
+
+QMaterialRippleSprites *QMaterialRippleSprites::instance()
+{
+    static const bool cleanupRegistered = [] {
+        qAddPostRoutine(clearRippleSprites);
+        return true;
+    }();
+    Q_UNUSED(cleanupRegistered);
+
+    return s_rippleSprites();
+}
+
+int QMaterialRippleSprites::bucketSize(qreal diameterPixels)
+{
+    int size = MinSpriteSize;
+    while (size < diameterPixels) {
+        if (size == MaxSpriteSize)
+            return 0;
+        size *= 2;
+    }
+    return size;
+}
+
+QImage QMaterialRippleSprites::renderSprite(const QColor &color, int size, bool soft)
+{
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter p(&image);
+    p.setRenderHint(QPainter::Antialiasing, true);
+    p.setPen(Qt::NoPen);
+
+    const QRectF disc(0, 0, size, size);
+    if (soft) {
+        // Плотная середина и плавный спад к краю
+        QColor edge = color;
+        edge.setAlpha(0);
+        QRadialGradient gradient(disc.center(), size / 2.0);
+        gradient.setColorAt(0.0, color);
+        gradient.setColorAt(0.6, color);
+        gradient.setColorAt(1.0, edge);
+        p.setBrush(gradient);
+    } else {
+        p.setBrush(color);
+    }
+    p.drawEllipse(disc);
+    p.end();
+
+    return image;
+}
+
+QPixmap QMaterialRippleSprites::sprite(const QColor &color, int size, bool soft)
+{
+    const quint64 key = spriteKey(color, size, soft);
+    if (QPixmap *cached = m_cache.object(key))
+        return *cached;
+
+    const QPixmap pixmap = QPixmap::fromImage(renderSprite(color, size, soft));
+    // QCache считает стоимость в int (Qt5), поэтому храним её в килобайтах
+    m_cache.insert(key, new QPixmap(pixmap), qMax(1, size * size * 4 / 1024));
+    return pixmap;
+}
+
+bool QMaterialRippleSprites::paint(QPainter &p, const QPointF &center, qreal radius,
+                                   const QColor &color, qreal opacity, bool soft)
+{
+    // Корзина по текущему диаметру: спрайт уменьшается не больше чем вдвое.
+    // Билинейное сглаживание без mip-уровней при сильном уменьшении дало бы
+    // рваный край, поэтому совсем маленькие круги рисуются эллипсом.
+    const qreal dpr = p.device() ? p.device()->devicePixelRatioF() : 1.0;
+    const qreal diameter = 2.0 * radius * dpr;
+    const int size = bucketSize(diameter);
+    if (size == 0 || diameter < size / 2.0)
+        return false;
+
+    const QPixmap pixmap = sprite(color, size, soft);
+    const QRectF target(center.x() - radius, center.y() - radius, 2.0 * radius, 2.0 * radius);
+
+    // Прозрачность и масштаб применяет drawPixmap — без пути и сглаживания
+    const bool smooth = p.testRenderHint(QPainter::SmoothPixmapTransform);
+    const qreal previousOpacity = p.opacity();
+    p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    p.setOpacity(previousOpacity * opacity);
+    p.drawPixmap(target, pixmap, QRectF(pixmap.rect()));
+    p.setOpacity(previousOpacity);
+    p.setRenderHint(QPainter::SmoothPixmapTransform, smooth);
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QCache>
+#include <QColor>
+#include <QImage>
+#include <QPixmap>
+#include <QtGlobal>
+
+class QPainter;
+class QPointF;
+
+// Как рисуется круг ripple
+enum class QMaterialRippleRenderer {
+    Ellipse,   // drawEllipse со сглаживанием в каждом кадре
+    Sprite,    // готовый диск из QMaterialRippleSprites, масштабируется и выводится с прозрачностью
+    SoftSprite // то же с мягким краем (радиальный градиент), по той же цене
+};
+
+// Общий для процесса кэш спрайтов ripple: один диск на цвет и корзину размера.
+// Корзины — степени двойки в физических пикселях; корзина выбирается по
+// текущему диаметру, так что спрайт при выводе уменьшается не больше чем вдвое
+// и край остаётся гладким. Используется только из GUI-потока.
+class QMaterialRippleSprites
+{
+public:
+    // Границы корзин в физических пикселях (диаметр спрайта)
+    static constexpr int MinSpriteSize = 16;
+    static constexpr int MaxSpriteSize = 1024;
+
+    QMaterialRippleSprites();
+
+    static QMaterialRippleSprites *instance();
+
+    // Рисует круг спрайтом. Растущий ripple проходит несколько корзин (по одной
+    // на удвоение радиуса), все они остаются в кэше. false — круг меньше
+    // половины самой мелкой корзины или больше самой крупной, его нужно
+    // рисовать обычным способом.
+    bool paint(QPainter &p, const QPointF &center, qreal radius,
+               const QColor &color, qreal opacity, bool soft);
+
+    // Спрайт из кэша, либо растеризует и кладёт в кэш
+    QPixmap sprite(const QColor &color, int size, bool soft);
+
+    // Наименьшая корзина, вмещающая диаметр (0 — больше MaxSpriteSize)
+    static int bucketSize(qreal diameterPixels);
+
+    // Растеризация спрайта в изображение (не обращается к кэшу)
+    static QImage renderSprite(const QColor &color, int size, bool soft);
+
+    int count() const { return int(m_cache.count()); }
+    qint64 usedBytes() const { return qint64(m_cache.totalCost()) * 1024; }
+    void clear() { m_cache.clear(); }
+
+private:
+    QCache<quint64, QPixmap> m_cache;
+};
@@ -0,0 +1,432 @@
+#include "QMaterialShadowCache.h"
+#include "QMaterialShadowKernel.h"
+
+#include <QCoreApplication>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPaintDevice>
+#include <QRunnable>
+#include <QThread>
+#include <QtMath>
+
+#include <limits>
+
+namespace {
+
+// Бюджет по умолчанию: 32 МБ растровых теней
+constexpr qint64 DefaultMaxBytes = 32 * 1024 * 1024;
+
+// Профиль аналитической тени в долях blurRadius: спад erfc с центром на
+// AnalyticShift снаружи края и шириной AnalyticSigma
+constexpr qreal AnalyticSigma = 0.25;
+constexpr qreal AnalyticShift = 0.4;
+
+// Отступ разреза nine-patch от края карточки. За ним тень вдоль края не
+// меняется: скругления всех концентрических слоёв имеют общие центры, так что
+// хватает radius + 1. Аналитическая тень внутри карточки ещё нарастает до
+// глубины 3 sigma - shift, и середина шаблона должна лежать глубже, иначе
+// растянутый центр светлее целой тени.
+int ninePatchInset(const QMaterialShadowSpec &spec)
+{
+    const int corner = qCeil(spec.cornerRadius) + 1;
+    if (spec.engine != QMaterialShadowEngine::Analytic)
+        return corner;
+
+    const qreal blur = spec.blurRadius();
+    const qreal depth = 3.0 * qMax(0.5, blur * AnalyticSigma) - blur * AnalyticShift;
+    return qMax(corner, qCeil(depth) + 1);
+}
+
+Q_GLOBAL_STATIC(QMaterialShadowCache, s_shadowCache)
+
+void clearShadowCache()
+{
+    // Пиксмапы должны быть освобождены до разрушения QGuiApplication,
+    // а фоновая растеризация — закончена
+    if (s_shadowCache.exists()) {
+        s_shadowCache()->waitForPrewarm();
+        s_shadowCache()->clear();
+    }
+}
+
+// Растеризация одной тени в пуле потоков. QImage и QPainter по изображению
+// безопасны вне GUI-потока; пиксмап создаётся уже в GUI-потоке.
+class ShadowRenderTask : public QRunnable
+{
+public:
+    explicit ShadowRenderTask(const QMaterialShadowKey &key)
+        : m_key(key)
+    {
+    }
+
+    void run() override
+    {
+        const QImage image = QMaterialShadowCache::renderShadow(m_key);
+        const QMaterialShadowKey key = m_key;
+
+        QCoreApplication *app = QCoreApplication::instance();
+        if (!app)
+            return;
+
+        QMetaObject::invokeMethod(app, [key, image] {
+            QMaterialShadowCache::instance()->insert(key, image);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    QMaterialShadowKey m_key;
+};
+
+} // namespace
+
+QMaterialShadowSpec QMaterialShadowKey::spec() const
+{
+    QMaterialShadowSpec s;
+    s.cornerRadius = cornerRadius / 4.0;
+    s.elevation = elevation * QMaterialShadowCache::ElevationQuantum;
+    s.intensity = intensity / 256.0;
+    s.engine = engine;
+    if (engine == QMaterialShadowEngine::Concentric) {
+        s.steps = steps;
+        s.antialiased = antialiased;
+    }
+    return s;
+}
+
+QMaterialHashValue qHash(const QMaterialShadowKey &key, QMaterialHashValue seed)
+{
+    QMaterialHashValue h = qHash(key.cardSize.width(), seed);
+    h = qHash(key.cardSize.height(), h);
+    h = qHash(key.cornerRadius, h);
+    h = qHash(key.elevation, h);
+    h = qHash(key.intensity, h);
+    h = qHash(key.dpr, h);
+    h = qHash(key.steps, h);
+    h = qHash(int(key.antialiased), h);
+    return qHash(int(key.engine), h);
+}
+
+QMaterialShadowCache::QMaterialShadowCache()
+    : m_cache(int(DefaultMaxBytes / 1024)),
+      m_hits(0),
+      m_misses(0),
+      m_enabled(true)
+{
+    // Один поток оставляем GUI
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+QMaterialShadowCache *QMaterialShadowCache::instance()
+{
+    static const bool cleanupRegistered = [] {
+        qAddPostRoutine(clearShadowCache);
+        return true;
+    }();
+    Q_UNUSED(cleanupRegistered);
+
+    return s_shadowCache();
+}
+
+void QMaterialShadowCache::setEnabled(bool on)
+{
+    if (m_enabled == on)
+        return;
+
+    m_enabled = on;
+    if (!m_enabled)
+        m_cache.clear();
+}
+
+qint64 QMaterialShadowCache::maxBytes() const
+{
+    return qint64(m_cache.maxCost()) * 1024;
+}
+
+void QMaterialShadowCache::setMaxBytes(qint64 bytes)
+{
+    m_cache.setMaxCost(int(qBound<qint64>(0, bytes / 1024, std::numeric_limits<int>::max())));
+}
+
+qint64 QMaterialShadowCache::usedBytes() const
+{
+    return qint64(m_cache.totalCost()) * 1024;
+}
+
+int QMaterialShadowCache::count() const
+{
+    return int(m_cache.count());
+}
+
+void QMaterialShadowCache::prewarm(const QVector<QMaterialShadowKey> &keys)
+{
+    if (!m_enabled)
+        return;
+
+    for (const QMaterialShadowKey &key : keys) {
+        if (key.cardSize.isEmpty() || m_cache.contains(key) || m_pending.contains(key))
+            continue;
+
+        m_pending.insert(key);
+        m_pool.start(new ShadowRenderTask(key));
+    }
+}
+
+void QMaterialShadowCache::insert(const QMaterialShadowKey &key, const QImage &image)
+{
+    m_pending.remove(key);
+
+    // Тень могла успеть отрисоваться синхронно, пока задача была в очереди
+    if (!m_enabled || image.isNull() || m_cache.contains(key))
+        return;
+
+    const QPixmap pixmap = QPixmap::fromImage(image);
+    m_cache.insert(key, new QPixmap(pixmap), costOf(pixmap));
+}
+
+void QMaterialShadowCache::waitForPrewarm()
+{
+    m_pool.waitForDone();
+}
+
+void QMaterialShadowCache::resetStatistics()
+{
+    m_hits = 0;
+    m_misses = 0;
+}
+
+void QMaterialShadowCache::clear()
+{
+    m_cache.clear();
+}
+
+int QMaterialShadowCache::costOf(const QPixmap &pixmap)
+{
+    const qint64 bytes = qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+    return int(qMax<qint64>(1, (bytes + 1023) / 1024));
+}
+
+QMaterialShadowKey QMaterialShadowCache::makeKey(const QSizeF &cardSize, const QMaterialShadowSpec &spec, qreal dpr)
+{
+    QMaterialShadowKey key;
+    key.cardSize = cardSize.toSize();
+    key.cornerRadius = qRound(spec.cornerRadius * 4.0);
+    key.elevation = qRound(spec.elevation / ElevationQuantum);
+    key.intensity = qRound(qBound(0.0, spec.intensity, 1.0) * 256.0);
+    key.dpr = qRound(dpr * 100.0);
+    key.engine = spec.engine;
+
+    // Аналитическая тень не зависит от настроек качества концентрической
+    if (spec.engine == QMaterialShadowEngine::Concentric) {
+        key.steps = qMax(1, spec.steps);
+        key.antialiased = spec.antialiased;
+    } else {
+        key.steps = 0;
+        key.antialiased = true;
+    }
+    return key;
+}
+
+QMaterialShadowKey QMaterialShadowCache::makeNinePatchKey(const QSizeF &cardSize, const QMaterialShadowSpec &spec, qreal dpr)
+{
+    QMaterialShadowKey key = makeKey(cardSize, spec, dpr);
+    const QSize templateSize = ninePatchCardSize(key.spec());
+
+    // Карточка меньше шаблона: растягивать нечего, тень рисуется целиком
+    if (key.cardSize.width() >= templateSize.width() && key.cardSize.height() >= templateSize.height())
+        key.cardSize = templateSize;
+    return key;
+}
+
+QMargins QMaterialShadowCache::shadowPadding(const QMaterialShadowSpec &spec)
+{
+    // +1 пиксель на сглаживание краёв
+    const int pad = qCeil(spec.blurRadius()) + 1;
+    return QMargins(pad, pad, pad, pad + qCeil(spec.yOffset()));
+}
+
+QMargins QMaterialShadowCache::shadowExtent(const QMaterialShadowSpec &spec)
+{
+    // В кэш попадает elevation, округлённый до шага квантования
+    return QMaterialElevation::shadowMargins(spec.elevation + ElevationQuantum / 2.0);
+}
+
+QImage QMaterialShadowCache::renderShadow(const QMaterialShadowKey &key)
+{
+    if (key.engine == QMaterialShadowEngine::Analytic)
+        return renderAnalyticShadow(key);
+
+    const QMaterialShadowSpec spec = key.spec();
+    const QMargins pad = shadowPadding(spec);
+    const qreal dpr = key.devicePixelRatio();
+
+    const QSize logicalSize(key.cardSize.width() + pad.left() + pad.right(),
+                            key.cardSize.height() + pad.top() + pad.bottom());
+
+    QImage image(QSize(qCeil(logicalSize.width() * dpr), qCeil(logicalSize.height() * dpr)),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    image.fill(Qt::transparent);
+
+    QPainter p(&image);
+    p.setRenderHint(QPainter::Antialiasing, spec.antialiased);
+    paintConcentricShadow(p, QRectF(QPointF(pad.left(), pad.top()), QSizeF(key.cardSize)), spec);
+    p.end();
+
+    return image;
+}
+
+QImage QMaterialShadowCache::renderAnalyticShadow(const QMaterialShadowKey &key)
+{
+    const QMaterialShadowSpec spec = key.spec();
+    const QMargins pad = shadowPadding(spec);
+    const qreal dpr = key.devicePixelRatio();
+    const qreal w = key.cardSize.width();
+    const qreal h = key.cardSize.height();
+
+    QImage image(QSize(qCeil((w + pad.left() + pad.right()) * dpr),
+                       qCeil((h + pad.top() + pad.bottom()) * dpr)),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+
+    // Пиковая альфа совпадает с суммой 8 концентрических слоёв под карточкой,
+    // а спад подобран под их профиль: середина на 0.4 blur, sigma = 0.25 blur
+    const qreal layerAlpha = spec.alpha() / 255.0 * spec.intensity;
+    qreal transparency = 1.0;
+    for (int i = 0; i < 8; ++i)
+        transparency *= 1.0 - layerAlpha * (1.0 - qreal(i + 1) / 8);
+
+    const qreal blur = spec.blurRadius() * dpr;
+
+    QMaterialShadowKernelParams params;
+    params.centerX = float((pad.left() + w / 2.0) * dpr);
+    params.centerY = float((pad.top() + spec.yOffset() + h / 2.0) * dpr);
+    params.halfWidth = float(w / 2.0 * dpr);
+    params.halfHeight = float(h / 2.0 * dpr);
+    params.radius = float(qMin(spec.cornerRadius, qMin(w, h) / 2.0) * dpr);
+    params.sigma = float(qMax(0.5, blur * AnalyticSigma));
+    params.shift = float(blur * AnalyticShift);
+    params.peak = float(1.0 - transparency);
+
+    QMaterialShadowKernel::render(image, params);
+    return image;
+}
+
+void QMaterialShadowCache::paintConcentricShadow(QPainter &p, const QRectF &cardRect, const QMaterialShadowSpec &spec)
+{
+    p.save();
+    p.setRenderHint(QPainter::Antialiasing, spec.antialiased);
+
+    // Немного опустим тень вниз, имитируя "поднятие"
+    const qreal yOffset = spec.yOffset();
+    const qreal blurRadius = spec.blurRadius();
+    const int steps = qMax(1, spec.steps);
+
+    QColor baseColor(0, 0, 0);
+    baseColor.setAlpha(spec.alpha());
+
+    for (int i = 0; i < steps; ++i) {
+        const qreal t = qreal(i + 1) / steps;
+        const qreal grow = blurRadius * t;
+
+        QRectF r = cardRect.adjusted(-grow, -grow, grow, grow);
+        r.translate(0, yOffset); // смещение вниз
+
+        QColor c = baseColor;
+        c.setAlphaF(baseColor.alphaF() * (1.0 - t) * spec.intensity);
+
+        QPainterPath path;
+        path.addRoundedRect(r, spec.cornerRadius + grow, spec.cornerRadius + grow);
+
+        p.setPen(Qt::NoPen);
+        p.setBrush(c);
+        p.drawPath(path);
+    }
+
+    p.restore();
+}
+
+QPixmap QMaterialShadowCache::shadowPixmap(const QMaterialShadowKey &key)
+{
+    if (const QPixmap *cached = m_cache.object(key)) {
+        ++m_hits;
+        return *cached;
+    }
+
+    ++m_misses;
+    const QPixmap pixmap = QPixmap::fromImage(renderShadow(key));
+
+    // QCache удаляет объект, если он не помещается в бюджет
+    m_cache.insert(key, new QPixmap(pixmap), costOf(pixmap));
+    return pixmap;
+}
+
+void QMaterialShadowCache::paintShadow(QPainter &p, const QRectF &cardRect, const QMaterialShadowSpec &spec)
+{
+    if (!m_enabled && spec.engine == QMaterialShadowEngine::Concentric) {
+        paintConcentricShadow(p, cardRect, spec);
+        return;
+    }
+
+    const qreal dpr = p.device() ? p.device()->devicePixelRatioF() : 1.0;
+    const QMaterialShadowKey key = makeKey(cardRect.size(), spec, dpr);
+    const QMargins pad = shadowPadding(key.spec());
+    const QPointF origin(cardRect.left() - pad.left(), cardRect.top() - pad.top());
+
+    if (!m_enabled) {
+        p.drawImage(origin, renderShadow(key));
+        return;
+    }
+
+    p.drawPixmap(origin, shadowPixmap(key));
+}
+
+QSize QMaterialShadowCache::ninePatchCardSize(const QMaterialShadowSpec &spec)
+{
+    // По вертикали тень опущена на yOffset, и верхний угол выше на столько же
+    const int inset = ninePatchInset(spec);
+    return QSize(2 * inset + 1, 2 * inset + qCeil(spec.yOffset()) + 1);
+}
+
+void QMaterialShadowCache::paintNinePatchShadow(QPainter &p, const QRectF &cardRect, const QMaterialShadowSpec &spec)
+{
+    const QMaterialShadowKey key = makeNinePatchKey(cardRect.size(), spec,
+                                                    p.device() ? p.device()->devicePixelRatioF() : 1.0);
+    const QMaterialShadowSpec keySpec = key.spec();
+    const QSize templateSize = ninePatchCardSize(keySpec);
+
+    // Карточка меньше шаблона: растягивать нечего
+    if (!m_enabled || key.cardSize != templateSize) {
+        paintShadow(p, cardRect, spec);
+        return;
+    }
+
+    const QPixmap pixmap = shadowPixmap(key);
+    const qreal dpr = pixmap.devicePixelRatio();
+    const QMargins pad = shadowPadding(keySpec);
+    const int corner = ninePatchInset(keySpec);
+    // Верхние углы тени кончаются ниже верхних углов карточки на yOffset
+    const int topCorner = corner + qCeil(keySpec.yOffset());
+
+    // Разбиение в логических координатах шаблона и цели
+    const qreal srcX[4] = { 0.0, qreal(pad.left() + corner),
+                            qreal(pad.left() + templateSize.width() - corner),
+                            qreal(pad.left() + templateSize.width() + pad.right()) };
+    const qreal srcY[4] = { 0.0, qreal(pad.top() + topCorner),
+                            qreal(pad.top() + templateSize.height() - corner),
+                            qreal(pad.top() + templateSize.height() + pad.bottom()) };
+
+    const QRectF target = cardRect.adjusted(-pad.left(), -pad.top(), pad.right(), pad.bottom());
+    const qreal dstX[4] = { target.left(), target.left() + srcX[1],
+                            target.right() - (srcX[3] - srcX[2]), target.right() };
+    const qreal dstY[4] = { target.top(), target.top() + srcY[1],
+                            target.bottom() - (srcY[3] - srcY[2]), target.bottom() };
+
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            const QRectF dst(QPointF(dstX[col], dstY[row]), QPointF(dstX[col + 1], dstY[row + 1]));
+            const QRectF src(QPointF(srcX[col] * dpr, srcY[row] * dpr),
+                             QPointF(srcX[col + 1] * dpr, srcY[row + 1] * dpr));
+            p.drawPixmap(dst, pixmap, src);
+        }
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "QMaterialElevation.h"
+
+#include <QCache>
+#include <QPixmap>
+#include <QImage>
+#include <QMargins>
+#include <QSet>
+#include <QSize>
+#include <QThreadPool>
+#include <QVector>
+#include <QtGlobal>
+
+class QPainter;
+class QRectF;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+using QMaterialHashValue = size_t;
+#else
+using QMaterialHashValue = uint;
+#endif
+
+// Алгоритм растеризации тени
+enum class QMaterialShadowEngine {
+    Concentric, // полупрозрачные концентрические скруглённые прямоугольники (8 по умолчанию)
+    Analytic    // гауссово размытие в замкнутой форме, один проход на пиксель
+};
+
+// Параметры тени, не зависящие от размера карточки
+struct QMaterialShadowSpec
+{
+    qreal cornerRadius = 12.0;
+    qreal elevation = 0.0;
+    qreal intensity = 1.0;
+    QMaterialShadowEngine engine = QMaterialShadowEngine::Concentric;
+
+    // Качество концентрической тени: число слоёв и сглаживание краёв
+    int steps = 8;
+    bool antialiased = true;
+
+    // Геометрия тени, выведенная из elevation (см. QMaterialElevation)
+    qreal yOffset() const { return QMaterialElevation::yOffset(elevation); }
+    qreal blurRadius() const { return QMaterialElevation::blurRadius(elevation); }
+    int alpha() const { return QMaterialElevation::alpha(elevation); }
+};
+
+// Ключ кэша: все величины квантованы, чтобы близкие значения давали одну запись
+struct QMaterialShadowKey
+{
+    QSize cardSize;
+    int cornerRadius = 0; // в 1/4 пикселя
+    int elevation = 0;    // в шагах QMaterialShadowCache::ElevationQuantum
+    int intensity = 0;    // в 1/256
+    int dpr = 100;        // devicePixelRatio * 100
+    QMaterialShadowEngine engine = QMaterialShadowEngine::Concentric;
+    int steps = 8;           // только для Concentric, у Analytic всегда 0
+    bool antialiased = true; // только для Concentric
+
+    QMaterialShadowSpec spec() const;
+    qreal devicePixelRatio() const { return dpr / 100.0; }
+
+    bool operator==(const QMaterialShadowKey &o) const
+    {
+        return cardSize == o.cardSize && cornerRadius == o.cornerRadius
+            && elevation == o.elevation && intensity == o.intensity && dpr == o.dpr
+            && engine == o.engine && steps == o.steps && antialiased == o.antialiased;
+    }
+};
+
+QMaterialHashValue qHash(const QMaterialShadowKey &key, QMaterialHashValue seed = 0);
+
+// Общий для процесса LRU-кэш отрисованных теней.
+// Используется только из GUI-потока; растеризация при prewarm() идёт в пуле
+// потоков, а готовые изображения попадают в кэш через очередь событий GUI-потока.
+class QMaterialShadowCache
+{
+public:
+    // Шаг квантования elevation (в единицах elevation)
+    static constexpr qreal ElevationQuantum = 0.25;
+
+    QMaterialShadowCache();
+
+    static QMaterialShadowCache *instance();
+
+    // Рисует тень под карточкой cardRect: из кэша, либо растеризует и кладёт в кэш
+    void paintShadow(QPainter &p, const QRectF &cardRect, const QMaterialShadowSpec &spec);
+
+    // То же, но из одного шаблона на (cornerRadius, elevation, intensity):
+    // углы копируются как есть, края и центр растягиваются под размер карточки
+    void paintNinePatchShadow(QPainter &p, const QRectF &cardRect, const QMaterialShadowSpec &spec);
+
+    // Насколько тень реально выходит за карточку с каждой стороны: размытие,
+    // смещение вниз и запас на квантование elevation и сглаживание
+    static QMargins shadowExtent(const QMaterialShadowSpec &spec);
+
+    // Заранее растеризует тени в фоновых потоках, не блокируя GUI-поток.
+    // Ключи, которые уже есть в кэше или уже в работе, пропускаются.
+    void prewarm(const QVector<QMaterialShadowKey> &keys);
+    // Кладёт готовое изображение в кэш (только из GUI-потока)
+    void insert(const QMaterialShadowKey &key, const QImage &image);
+    // Число ключей, отправленных в пул и ещё не попавших в кэш
+    int pendingCount() const { return int(m_pending.size()); }
+    // Дожидается окончания растеризации (изображения придут следующими событиями)
+    void waitForPrewarm();
+
+    bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool on);
+
+    // Бюджет памяти кэша в байтах
+    qint64 maxBytes() const;
+    void setMaxBytes(qint64 bytes);
+    qint64 usedBytes() const;
+    int count() const;
+
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+    void resetStatistics();
+    void clear();
+
+    static QMaterialShadowKey makeKey(const QSizeF &cardSize, const QMaterialShadowSpec &spec, qreal dpr);
+    // Ключ шаблона, который использует paintNinePatchShadow (для маленьких карточек — обычный ключ)
+    static QMaterialShadowKey makeNinePatchKey(const QSizeF &cardSize, const QMaterialShadowSpec &spec, qreal dpr);
+
+    // Отступы изображения тени относительно карточки
+    static QMargins shadowPadding(const QMaterialShadowSpec &spec);
+
+    // Размер шаблонной карточки для nine-patch режима
+    static QSize ninePatchCardSize(const QMaterialShadowSpec &spec);
+
+    // Растеризация тени в изображение (не обращается к кэшу)
+    static QImage renderShadow(const QMaterialShadowKey &key);
+
+    // Прямое рисование тени концентрическими скруглёнными прямоугольниками
+    static void paintConcentricShadow(QPainter &p, const QRectF &cardRect, const QMaterialShadowSpec &spec);
+
+    // Растеризация аналитической тени (SIMD-ядро QMaterialShadowKernel)
+    static QImage renderAnalyticShadow(const QMaterialShadowKey &key);
+
+private:
+    QPixmap shadowPixmap(const QMaterialShadowKey &key);
+
+    // QCache считает стоимость в int (Qt5), поэтому храним её в килобайтах
+    static int costOf(const QPixmap &pixmap);
+
+    QCache<QMaterialShadowKey, QPixmap> m_cache;
+    QSet<QMaterialShadowKey> m_pending;
+    QThreadPool m_pool;
+    quint64 m_hits;
+    quint64 m_misses;
+    bool m_enabled;
+};
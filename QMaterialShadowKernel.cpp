@@ -0,0 +1,291 @@
+#include "QMaterialShadowKernel.h"
+
+#include <QImage>
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define QMATERIAL_HAVE_SSE2
+#  include <emmintrin.h>
+#endif
+
+// AVX2: на GCC/Clang собираем отдельную функцию с target-атрибутом и выбираем
+// её во время выполнения; на остальных компиляторах — только если AVX2 включён флагами
+#if defined(QMATERIAL_HAVE_SSE2)
+#  if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#    define QMATERIAL_HAVE_AVX2
+#    define QMATERIAL_AVX2_TARGET __attribute__((target("avx2")))
+#    include <immintrin.h>
+#  elif defined(__AVX2__)
+#    define QMATERIAL_HAVE_AVX2
+#    define QMATERIAL_AVX2_TARGET
+#    include <immintrin.h>
+#  endif
+#endif
+
+namespace {
+
+// Коэффициенты приближения erf (Abramowitz–Stegun 7.1.27, погрешность 5e-4):
+// erf(x) ≈ 1 - 1 / (1 + a1 x + a2 x^2 + a3 x^3 + a4 x^4)^4, x >= 0.
+// Не требует exp, поэтому хорошо векторизуется.
+constexpr float ErfA1 = 0.278393f;
+constexpr float ErfA2 = 0.230389f;
+constexpr float ErfA3 = 0.000972f;
+constexpr float ErfA4 = 0.078108f;
+constexpr float InvSqrt2 = 0.70710678f;
+
+// Общие для всех строк величины
+struct RowSetup
+{
+    float coreHalfWidth;  // halfWidth - radius
+    float coreHalfHeight; // halfHeight - radius
+    float invSigma;       // 1 / (sigma * sqrt(2))
+    float peak255;
+};
+
+RowSetup makeSetup(const QMaterialShadowKernelParams &params)
+{
+    RowSetup s;
+    s.coreHalfWidth = params.halfWidth - params.radius;
+    s.coreHalfHeight = params.halfHeight - params.radius;
+    s.invSigma = InvSqrt2 / (params.sigma > 0.0f ? params.sigma : 1.0f);
+    s.peak255 = params.peak * 255.0f;
+    return s;
+}
+
+inline float shadowAlpha(float px, float qy, const RowSetup &s, const QMaterialShadowKernelParams &params)
+{
+    // Расстояние со знаком до скруглённого прямоугольника
+    const float qx = std::fabs(px) - s.coreHalfWidth;
+    const float ox = qx > 0.0f ? qx : 0.0f;
+    const float oy = qy > 0.0f ? qy : 0.0f;
+    const float inside = qx > qy ? qx : qy;
+    const float d = std::sqrt(ox * ox + oy * oy) + (inside < 0.0f ? inside : 0.0f) - params.radius;
+
+    // 0.5 * erfc(z)
+    const float z = (d - params.shift) * s.invSigma;
+    const float x = std::fabs(z);
+    float poly = 1.0f + x * (ErfA1 + x * (ErfA2 + x * (ErfA3 + x * ErfA4)));
+    poly *= poly;
+    poly *= poly;
+    const float half = 0.5f / poly;
+    return (z >= 0.0f ? half : 1.0f - half) * s.peak255;
+}
+
+void renderScalar(QImage &image, const QMaterialShadowKernelParams &params)
+{
+    const RowSetup s = makeSetup(params);
+    const int w = image.width();
+
+    for (int y = 0; y < image.height(); ++y) {
+        quint32 *line = reinterpret_cast<quint32 *>(image.scanLine(y));
+        const float qy = std::fabs(y + 0.5f - params.centerY) - s.coreHalfHeight;
+
+        for (int x = 0; x < w; ++x) {
+            const float a = shadowAlpha(x + 0.5f - params.centerX, qy, s, params);
+            line[x] = quint32(int(a + 0.5f)) << 24;
+        }
+    }
+}
+
+#if defined(QMATERIAL_HAVE_SSE2)
+void renderSse2(QImage &image, const QMaterialShadowKernelParams &params)
+{
+    const RowSetup s = makeSetup(params);
+    const int w = image.width();
+
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 a1 = _mm_set1_ps(ErfA1);
+    const __m128 a2 = _mm_set1_ps(ErfA2);
+    const __m128 a3 = _mm_set1_ps(ErfA3);
+    const __m128 a4 = _mm_set1_ps(ErfA4);
+    const __m128 coreW = _mm_set1_ps(s.coreHalfWidth);
+    const __m128 radius = _mm_set1_ps(params.radius);
+    const __m128 shift = _mm_set1_ps(params.shift);
+    const __m128 invSigma = _mm_set1_ps(s.invSigma);
+    const __m128 peak = _mm_set1_ps(s.peak255);
+    const __m128 step = _mm_set1_ps(4.0f);
+
+    for (int y = 0; y < image.height(); ++y) {
+        quint32 *line = reinterpret_cast<quint32 *>(image.scanLine(y));
+        const float qyScalar = std::fabs(y + 0.5f - params.centerY) - s.coreHalfHeight;
+        const __m128 qy = _mm_set1_ps(qyScalar);
+        const __m128 oy = _mm_max_ps(qy, zero);
+        const __m128 oy2 = _mm_mul_ps(oy, oy);
+
+        __m128 px = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        px = _mm_sub_ps(px, _mm_set1_ps(params.centerX));
+
+        int x = 0;
+        for (; x + 4 <= w; x += 4) {
+            const __m128 qx = _mm_sub_ps(_mm_and_ps(px, signMask), coreW);
+            const __m128 ox = _mm_max_ps(qx, zero);
+            const __m128 inside = _mm_min_ps(_mm_max_ps(qx, qy), zero);
+            const __m128 outside = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ox, ox), oy2));
+            const __m128 d = _mm_sub_ps(_mm_add_ps(outside, inside), radius);
+
+            const __m128 z = _mm_mul_ps(_mm_sub_ps(d, shift), invSigma);
+            const __m128 ax = _mm_and_ps(z, signMask);
+            __m128 poly = _mm_add_ps(a3, _mm_mul_ps(ax, a4));
+            poly = _mm_add_ps(a2, _mm_mul_ps(ax, poly));
+            poly = _mm_add_ps(a1, _mm_mul_ps(ax, poly));
+            poly = _mm_add_ps(one, _mm_mul_ps(ax, poly));
+            poly = _mm_mul_ps(poly, poly);
+            poly = _mm_mul_ps(poly, poly);
+            const __m128 tail = _mm_div_ps(half, poly);
+
+            // z >= 0 ? tail : 1 - tail
+            const __m128 positive = _mm_cmpge_ps(z, zero);
+            const __m128 value = _mm_or_ps(_mm_and_ps(positive, tail),
+                                           _mm_andnot_ps(positive, _mm_sub_ps(one, tail)));
+
+            const __m128i alpha = _mm_cvtps_epi32(_mm_mul_ps(value, peak));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(line + x), _mm_slli_epi32(alpha, 24));
+
+            px = _mm_add_ps(px, step);
+        }
+
+        for (; x < w; ++x) {
+            const float a = shadowAlpha(x + 0.5f - params.centerX, qyScalar, s, params);
+            line[x] = quint32(int(a + 0.5f)) << 24;
+        }
+    }
+}
+#endif
+
+#if defined(QMATERIAL_HAVE_AVX2)
+QMATERIAL_AVX2_TARGET
+void renderAvx2(QImage &image, const QMaterialShadowKernelParams &params)
+{
+    const RowSetup s = makeSetup(params);
+    const int w = image.width();
+
+    const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 a1 = _mm256_set1_ps(ErfA1);
+    const __m256 a2 = _mm256_set1_ps(ErfA2);
+    const __m256 a3 = _mm256_set1_ps(ErfA3);
+    const __m256 a4 = _mm256_set1_ps(ErfA4);
+    const __m256 coreW = _mm256_set1_ps(s.coreHalfWidth);
+    const __m256 radius = _mm256_set1_ps(params.radius);
+    const __m256 shift = _mm256_set1_ps(params.shift);
+    const __m256 invSigma = _mm256_set1_ps(s.invSigma);
+    const __m256 peak = _mm256_set1_ps(s.peak255);
+    const __m256 step = _mm256_set1_ps(8.0f);
+
+    for (int y = 0; y < image.height(); ++y) {
+        quint32 *line = reinterpret_cast<quint32 *>(image.scanLine(y));
+        const float qyScalar = std::fabs(y + 0.5f - params.centerY) - s.coreHalfHeight;
+        const __m256 qy = _mm256_set1_ps(qyScalar);
+        const __m256 oy = _mm256_max_ps(qy, zero);
+        const __m256 oy2 = _mm256_mul_ps(oy, oy);
+
+        __m256 px = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        px = _mm256_sub_ps(px, _mm256_set1_ps(params.centerX));
+
+        int x = 0;
+        for (; x + 8 <= w; x += 8) {
+            const __m256 qx = _mm256_sub_ps(_mm256_and_ps(px, signMask), coreW);
+            const __m256 ox = _mm256_max_ps(qx, zero);
+            const __m256 inside = _mm256_min_ps(_mm256_max_ps(qx, qy), zero);
+            const __m256 outside = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), oy2));
+            const __m256 d = _mm256_sub_ps(_mm256_add_ps(outside, inside), radius);
+
+            const __m256 z = _mm256_mul_ps(_mm256_sub_ps(d, shift), invSigma);
+            const __m256 ax = _mm256_and_ps(z, signMask);
+            __m256 poly = _mm256_add_ps(a3, _mm256_mul_ps(ax, a4));
+            poly = _mm256_add_ps(a2, _mm256_mul_ps(ax, poly));
+            poly = _mm256_add_ps(a1, _mm256_mul_ps(ax, poly));
+            poly = _mm256_add_ps(one, _mm256_mul_ps(ax, poly));
+            poly = _mm256_mul_ps(poly, poly);
+            poly = _mm256_mul_ps(poly, poly);
+            const __m256 tail = _mm256_div_ps(half, poly);
+
+            const __m256 positive = _mm256_cmp_ps(z, zero, _CMP_GE_OQ);
+            const __m256 value = _mm256_blendv_ps(_mm256_sub_ps(one, tail), tail, positive);
+
+            const __m256i alpha = _mm256_cvtps_epi32(_mm256_mul_ps(value, peak));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(line + x), _mm256_slli_epi32(alpha, 24));
+
+            px = _mm256_add_ps(px, step);
+        }
+
+        for (; x < w; ++x) {
+            const float a = shadowAlpha(x + 0.5f - params.centerX, qyScalar, s, params);
+            line[x] = quint32(int(a + 0.5f)) << 24;
+        }
+    }
+}
+
+bool cpuHasAvx2()
+{
+#if defined(__GNUC__)
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+#else
+    return true; // собрано с __AVX2__
+#endif
+}
+#endif
+
+} // namespace
+
+namespace QMaterialShadowKernel {
+
+Backend bestBackend()
+{
+#if defined(QMATERIAL_HAVE_AVX2)
+    if (cpuHasAvx2())
+        return Avx2Backend;
+#endif
+#if defined(QMATERIAL_HAVE_SSE2)
+    return Sse2Backend;
+#else
+    return ScalarBackend;
+#endif
+}
+
+const char *backendName(Backend backend)
+{
+    switch (backend) {
+    case Avx2Backend:
+        return "avx2";
+    case Sse2Backend:
+        return "sse2";
+    case ScalarBackend:
+        break;
+    }
+    return "scalar";
+}
+
+void render(QImage &image, const QMaterialShadowKernelParams &params, Backend backend)
+{
+    Q_ASSERT(image.format() == QImage::Format_ARGB32_Premultiplied);
+
+    if (backend > bestBackend())
+        backend = bestBackend();
+
+    switch (backend) {
+#if defined(QMATERIAL_HAVE_AVX2)
+    case Avx2Backend:
+        renderAvx2(image, params);
+        return;
+#endif
+#if defined(QMATERIAL_HAVE_SSE2)
+    case Sse2Backend:
+        renderSse2(image, params);
+        return;
+#endif
+    default:
+        break;
+    }
+
+    renderScalar(image, params);
+}
+
+} // namespace QMaterialShadowKernel
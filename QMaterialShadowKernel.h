@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QtGlobal>
+
+class QImage;
+
+// Аналитическая тень скруглённого прямоугольника: альфа пикселя вычисляется
+// за один проход как erfc от расстояния до скруглённого прямоугольника.
+// Все величины — в пикселях изображения.
+struct QMaterialShadowKernelParams
+{
+    float centerX = 0.0f;   // центр прямоугольника тени
+    float centerY = 0.0f;
+    float halfWidth = 0.0f;
+    float halfHeight = 0.0f;
+    float radius = 0.0f;    // радиус скругления
+    float sigma = 1.0f;     // ширина размытия (среднеквадратичное отклонение)
+    float shift = 0.0f;     // смещение середины спада наружу от края
+    float peak = 0.0f;      // альфа под карточкой (0..1)
+};
+
+namespace QMaterialShadowKernel {
+
+enum Backend {
+    ScalarBackend,
+    Sse2Backend,
+    Avx2Backend
+};
+
+// Лучшая реализация, доступная на текущем процессоре
+Backend bestBackend();
+const char *backendName(Backend backend);
+
+// Заполняет image (Format_ARGB32_Premultiplied) чёрной тенью.
+// Если backend недоступен, используется ближайший доступный.
+void render(QImage &image, const QMaterialShadowKernelParams &params,
+            Backend backend = bestBackend());
+
+} // namespace QMaterialShadowKernel
@@ -0,0 +1,150 @@
+#include "QMaterialSurface.h"
+#include "QMaterialWidget.h"
+
+#include <QChildEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOption>
+
+#include <algorithm>
+#include <utility>
+
+QMaterialSurface::QMaterialSurface(QWidget *parent)
+    : QWidget(parent)
+{
+}
+
+QMaterialSurface::~QMaterialSurface()
+{
+    // Дети удаляются уже после этого деструктора: отвязываем их заранее
+    for (QMaterialWidget *card : std::as_const(m_cards)) {
+        card->removeEventFilter(this);
+        card->m_surface = nullptr;
+    }
+}
+
+void QMaterialSurface::childEvent(QChildEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::ChildAdded:
+    case QEvent::ChildPolished:
+        // Карточка, созданная сразу с родителем, в ChildAdded ещё не достроена
+        // (qobject_cast не сработает) — её подхватит ChildPolished
+        addCard(event->child());
+        break;
+    case QEvent::ChildRemoved:
+        removeCard(event->child(), true);
+        break;
+    default:
+        break;
+    }
+
+    QWidget::childEvent(event);
+}
+
+void QMaterialSurface::addCard(QObject *child)
+{
+    QMaterialWidget *card = qobject_cast<QMaterialWidget *>(child);
+    if (!card || card->m_surface == this)
+        return;
+
+    m_cards.append(card);
+    card->installEventFilter(this);
+    card->setShadowSurface(this);
+    updateCardShadow(card);
+}
+
+void QMaterialSurface::removeCard(QObject *child, bool restore)
+{
+    // Сравниваем указатели: удаляемую карточку уже нельзя привести через qobject_cast
+    const auto it = std::find_if(m_cards.begin(), m_cards.end(), [child](QMaterialWidget *card) {
+        return static_cast<QObject *>(card) == child;
+    });
+    if (it == m_cards.end())
+        return;
+
+    QMaterialWidget *card = *it;
+    m_cards.erase(it);
+    update(m_shadowRects.take(card));
+
+    card->removeEventFilter(this);
+    if (restore) {
+        card->setShadowSurface(nullptr);
+    } else {
+        card->m_surface = nullptr;
+    }
+}
+
+bool QMaterialSurface::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::Move:
+    case QEvent::Resize:
+    case QEvent::Show:
+    case QEvent::Hide:
+        // Сюда приходят события только от размещённых карточек
+        updateCardShadow(static_cast<QMaterialWidget *>(watched));
+        break;
+    default:
+        break;
+    }
+
+    return QWidget::eventFilter(watched, event);
+}
+
+QRect QMaterialSurface::cardShadowRect(QMaterialWidget *card) const
+{
+    if (!card->isVisibleTo(this))
+        return QRect();
+
+    return card->shadowRect(card->elevation()).translated(card->pos());
+}
+
+void QMaterialSurface::updateCardShadow(QMaterialWidget *card)
+{
+    const QRect shadow = cardShadowRect(card);
+    QRegion damage(m_shadowRects.value(card));
+    damage += shadow;
+
+    if (shadow.isEmpty()) {
+        m_shadowRects.remove(card);
+    } else {
+        m_shadowRects.insert(card, shadow);
+    }
+
+    // Под непрозрачным фоном карточки тень не видна
+    if (!shadow.isEmpty() && card->isBackgroundOpaque())
+        damage -= card->opaqueInteriorRegion(card->effectiveCardRect()).translated(card->pos());
+
+    if (damage.isEmpty())
+        return;
+
+    // Перерисовка поверхности под карточкой перерисовывает и её саму:
+    // для слоя карточки это запрошенная область, а не изменение детей
+    card->addLayerDamage(damage.translated(-card->pos()) & card->rect());
+    update(damage);
+}
+
+void QMaterialSurface::paintEvent(QPaintEvent *event)
+{
+    QPainter p(this);
+
+    // Фон поверхности из QSS, как у обычного QWidget
+    QStyleOption opt;
+    opt.initFrom(this);
+    style()->drawPrimitive(QStyle::PE_Widget, &opt, &p, this);
+
+    // Тени всех карточек за один проход, под всеми карточками
+    p.setRenderHint(QPainter::Antialiasing, true);
+    for (QMaterialWidget *card : std::as_const(m_cards)) {
+        const QRect shadow = m_shadowRects.value(card);
+        if (shadow.isEmpty() || !event->region().intersects(shadow))
+            continue;
+
+        p.save();
+        p.translate(card->pos());
+        card->paintShadow(p, card->effectiveCardRect());
+        p.restore();
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QHash>
+#include <QRect>
+#include <QVector>
+#include <QWidget>
+
+class QMaterialWidget;
+
+// Контейнер для карточек: тени всех дочерних QMaterialWidget рисуются на самой
+// поверхности за один проход её paintEvent. Размещённым карточкам не нужны
+// прозрачные shadowMargins, поэтому они занимают меньше пикселей backing store,
+// а поля соседних карточек не перекрываются и не компонуются повторно.
+//
+// Учитываются только прямые дочерние карточки. Место под тени оставляют
+// отступы и spacing раскладки поверхности: всё, что выходит за её пределы,
+// обрезается.
+class QMaterialSurface : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit QMaterialSurface(QWidget *parent = nullptr);
+    ~QMaterialSurface() override;
+
+    // Карточки, тени которых рисует поверхность
+    QVector<QMaterialWidget *> cards() const { return m_cards; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void childEvent(QChildEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    friend class QMaterialWidget;
+
+    void addCard(QObject *child);
+    // restore == false — карточка удаляется и её состояние трогать нельзя
+    void removeCard(QObject *child, bool restore);
+    // Перерисовывает прежнюю и новую область тени карточки
+    void updateCardShadow(QMaterialWidget *card);
+    QRect cardShadowRect(QMaterialWidget *card) const;
+
+    QVector<QMaterialWidget *> m_cards;
+    // Последняя нарисованная область тени каждой карточки, в координатах поверхности
+    QHash<QMaterialWidget *, QRect> m_shadowRects;
+};
@@ -1,31 +1,129 @@
 #include "QMaterialWidget.h"
+#include "QMaterialShadowCache.h"
+#include "QMaterialSurface.h"
 
 #include <QPainter>
 #include <QStyleOption>
 #include <QMouseEvent>
-#include <QEasingCurve>
 #include <QStyle>
+#include <QImage>
+#include <QLoggingCategory>
+#include <QPaintEvent>
+#include <QChildEvent>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+#include <QWindow>
+#include <QtMath>
+
+#include <algorithm>
+#include <utility>
+
+Q_LOGGING_CATEGORY(lcMaterialDamage, "qmaterialwidget.damage")
+Q_LOGGING_CATEGORY(lcMaterialStats, "qmaterialwidget.stats")
+
+namespace {
+
+bool s_damageDebug = qEnvironmentVariableIsSet("QMATERIALWIDGET_DEBUG_DAMAGE");
+
+// Общее состояние сбора статистики
+struct StatisticsState
+{
+    StatisticsState()
+        : enabled(qEnvironmentVariableIntValue("QMATERIALWIDGET_STATS") != 0),
+          logIntervalMs(qEnvironmentVariableIsSet("QMATERIALWIDGET_STATS_INTERVAL")
+                            ? qEnvironmentVariableIntValue("QMATERIALWIDGET_STATS_INTERVAL")
+                            : 5000)
+    {
+    }
+
+    bool enabled;
+    int logIntervalMs;
+    QMaterialWidget::PaintStatistics global;
+    QSet<QMaterialWidget *> instances;
+    QPointer<QTimer> logTimer;
+};
+
+StatisticsState &statisticsState()
+{
+    static StatisticsState state;
+    return state;
+}
+
+void recordPhase(QMaterialWidget::PhaseStatistics &phase, qint64 ns)
+{
+    phase.totalNs += ns;
+    phase.maxNs = qMax(phase.maxNs, ns);
+}
+
+void updateLogTimer()
+{
+    StatisticsState &state = statisticsState();
+    const bool wanted = state.enabled && state.logIntervalMs > 0 && QCoreApplication::instance();
+
+    if (!wanted) {
+        delete state.logTimer;
+        return;
+    }
+
+    if (!state.logTimer) {
+        state.logTimer = new QTimer(QCoreApplication::instance());
+        QObject::connect(state.logTimer, &QTimer::timeout, [] {
+            QMaterialWidget::logStatisticsSummary();
+        });
+    }
+    state.logTimer->setInterval(state.logIntervalMs);
+    if (!state.logTimer->isActive())
+        state.logTimer->start();
+}
+
+// Глобальная транзакция обновлений (beginGlobalUpdate/commitGlobalUpdate)
+struct TransactionState
+{
+    int depth = 0;
+    QVector<QPointer<QMaterialWidget>> widgets; // карточки с отложенными действиями
+};
+
+TransactionState &transactionState()
+{
+    static TransactionState state;
+    return state;
+}
+
+// Сколько разных devicePixelRatio держит кэш фона одной карточки
+constexpr int MaxBackgroundRatios = 4;
+
+// Общий слой для ripple в режиме MaskClip: растёт до самой большой области
+// и переиспользуется всеми карточками (рисование только в GUI-потоке)
+QImage &rippleLayer(const QSize &pixels, qreal dpr)
+{
+    static QImage layer;
+    if (layer.width() < pixels.width() || layer.height() < pixels.height()) {
+        layer = QImage(pixels.expandedTo(layer.size()), QImage::Format_ARGB32_Premultiplied);
+    }
+    layer.setDevicePixelRatio(dpr);
+    return layer;
+}
+
+QDebug operator<<(QDebug debug, const QMaterialWidget::PhaseStatistics &phase)
+{
+    QDebugStateSaver saver(debug);
+    debug.nospace() << phase.totalNs / 1e6 << " ms (max " << phase.maxNs / 1e6 << " ms)";
+    return debug;
+}
+
+} // namespace
 
 QMaterialWidget::QMaterialWidget(QWidget *parent)
     : QWidget(parent),
-      m_elevationEnabled(true),
-      m_shadowEnabled(true),
-      m_rippleEnabled(true),
+      m_config(defaultConfig()),
       m_elevation(2.0),
-      m_cornerRadius(12.0),
-      m_restElevation(2.0),
-      m_hoverElevation(6.0),
-      m_pressedElevation(10.0),
-      m_elevationAnim(new QPropertyAnimation(this, "elevation", this)),
-      m_rippleRadius(0.0),
-      m_rippleMaxRadius(0.0),
-      m_rippleOpacity(0.0),
-      m_rippleColor(0, 0, 0, 80),
-      m_rippleDurationMs(250),
-      m_mousePressedInside(false),
-      m_shadowMargins(24, 24, 24, 36),
-      m_userContentsMargins(0, 0, 0, 0),
-      m_shadowIntensity(1.0)
+      m_surface(nullptr),
+      m_updateDepth(0),
+      m_pendingUpdates(0)
 {
     // Не используем WA_StyledBackground, чтобы фон не рисовался под тенью
     // Вместо этого будем рисовать фон вручную только внутри области карточки
@@ -33,14 +131,29 @@ QMaterialWidget::QMaterialWidget(QWidget *parent)
     setAutoFillBackground(false);
     applyEffectiveContentsMargins();
 
-    // Анимация elevation
-    m_elevationAnim->setDuration(150);
-    m_elevationAnim->setEasingCurve(QEasingCurve::OutCubic);
+    // Анимации elevation и ripple продвигает общий QMaterialAnimationDriver
+}
+
+QMaterialWidget::~QMaterialWidget()
+{
+    if (m_surface)
+        m_surface->removeCard(this, false);
+    QMaterialAnimationDriver::instance()->stop(this);
+    statisticsState().instances.remove(this);
+}
 
-    // Ripple таймер
-    m_rippleTimer.setInterval(16); // ~60 FPS
-    connect(&m_rippleTimer, &QTimer::timeout,
-            this, &QMaterialWidget::updateRipple);
+QSharedDataPointer<QMaterialWidget::Config> QMaterialWidget::defaultConfig()
+{
+    // Один объект настроек по умолчанию на все карточки
+    static const QSharedDataPointer<Config> config(new Config);
+    return config;
+}
+
+QMaterialWidget::InteractionState &QMaterialWidget::interaction()
+{
+    if (!m_interaction)
+        m_interaction.reset(new InteractionState);
+    return *m_interaction;
 }
 
 void QMaterialWidget::setElevation(qreal value)
@@ -48,89 +161,480 @@ void QMaterialWidget::setElevation(qreal value)
     if (qFuzzyCompare(m_elevation, value))
         return;
 
+    const qreal previous = m_elevation;
     m_elevation = value;
     emit elevationChanged(m_elevation);
-    update();
+    updateShadow(previous);
 }
 
 void QMaterialWidget::setElevationEnabled(bool on)
 {
-    if (m_elevationEnabled == on)
+    if (config().elevationEnabled == on)
         return;
 
-    m_elevationEnabled = on;
+    m_config->elevationEnabled = on;
+    updateAutoShadowMargins();
 
-    if (!m_elevationEnabled) {
-        m_elevationAnim->stop();
+    if (!config().elevationEnabled) {
+        stopElevationAnimation();
         m_elevation = 0.0;
-        update();
+        updateCard();
     } else {
         // вернёмся к базовому состоянию
-        startElevationAnimation(m_restElevation);
+        startElevationAnimation(config().restElevation);
     }
 }
 
 void QMaterialWidget::setShadowEnabled(bool on)
 {
-    if (m_shadowEnabled == on)
+    if (config().shadowEnabled == on)
         return;
 
-    m_shadowEnabled = on;
-    update();
+    m_config->shadowEnabled = on;
+    updateAutoShadowMargins();
+    updateCard();
 }
 
 void QMaterialWidget::setShadowIntensity(qreal intensity)
 {
     intensity = qBound(0.0, intensity, 1.0);
-    if (qFuzzyCompare(m_shadowIntensity, intensity))
+    if (qFuzzyCompare(config().shadowIntensity, intensity))
+        return;
+
+    m_config->shadowIntensity = intensity;
+    updateCard();
+}
+
+void QMaterialWidget::setShadowMode(ShadowMode mode)
+{
+    if (config().shadowMode == mode)
+        return;
+
+    m_config->shadowMode = mode;
+    updateCard();
+}
+
+void QMaterialWidget::setShadowEngine(ShadowEngine engine)
+{
+    if (config().shadowEngine == engine)
         return;
 
-    m_shadowIntensity = intensity;
-    update();
+    m_config->shadowEngine = engine;
+    updateCard();
+}
+
+void QMaterialWidget::prewarmShadows()
+{
+    if (!config().shadowEnabled || !config().elevationEnabled)
+        return;
+
+    const QRectF cardRect = effectiveCardRect();
+    if (cardRect.isEmpty())
+        return;
+
+    // Переходы проходят через все кванты между крайними состояниями
+    const qreal quantum = QMaterialShadowCache::ElevationQuantum;
+    const qreal low = qMin(config().restElevation, qMin(config().hoverElevation, config().pressedElevation));
+    const qreal high = qMax(config().restElevation, qMax(config().hoverElevation, config().pressedElevation));
+    const int first = qMax(1, qRound(low / quantum));
+    const int last = qRound(high / quantum);
+
+    const qreal dpr = devicePixelRatioF();
+    QVector<QMaterialShadowKey> keys;
+    keys.reserve(qMax(0, last - first + 1));
+
+    for (int step = first; step <= last; ++step) {
+        const QMaterialShadowSpec spec = shadowSpec(step * quantum);
+        keys.append(config().shadowMode == NinePatchShadow
+                        ? QMaterialShadowCache::makeNinePatchKey(cardRect.size(), spec, dpr)
+                        : QMaterialShadowCache::makeKey(cardRect.size(), spec, dpr));
+    }
+
+    QMaterialShadowCache::instance()->prewarm(keys);
+}
+
+void QMaterialWidget::prewarmShadows(QWidget *root)
+{
+    if (!root)
+        return;
+
+    if (QMaterialWidget *card = qobject_cast<QMaterialWidget *>(root))
+        card->prewarmShadows();
+
+    const QList<QMaterialWidget *> cards = root->findChildren<QMaterialWidget *>();
+    for (QMaterialWidget *card : cards)
+        card->prewarmShadows();
+}
+
+void QMaterialWidget::setAdaptiveQualityEnabled(bool on)
+{
+    if (config().adaptiveQuality == on)
+        return;
+
+    m_config->adaptiveQuality = on;
+    if (!m_interaction)
+        return;
+
+    m_interaction->quality.averagePaintMs = 0.0;
+    m_interaction->quality.overBudgetFrames = 0;
+
+    if (!on && !m_interaction->quality.pinned)
+        setQualityLevel(FullQuality);
+}
+
+void QMaterialWidget::setPaintBudget(qreal ms)
+{
+    ms = qMax<qreal>(0.1, ms);
+    if (qFuzzyCompare(config().paintBudgetMs, ms))
+        return;
+
+    m_config->paintBudgetMs = ms;
+}
+
+void QMaterialWidget::pinQualityLevel(QualityLevel level)
+{
+    interaction().quality.pinned = true;
+    setQualityLevel(level);
+}
+
+void QMaterialWidget::unpinQualityLevel()
+{
+    if (!isQualityLevelPinned())
+        return;
+
+    QualityState &quality = m_interaction->quality;
+    quality.pinned = false;
+    quality.averagePaintMs = 0.0;
+    quality.overBudgetFrames = 0;
+
+    // Адаптация начнётся заново с полного качества
+    setQualityLevel(FullQuality);
+}
+
+void QMaterialWidget::setQualityLevel(QualityLevel level)
+{
+    if (qualityLevel() == level)
+        return;
+
+    interaction().quality.level = level;
+
+    // Слои тени входят в ключ кэша, поэтому перерисовываем карточку целиком
+    updateCard();
+    emit qualityLevelChanged(level);
+}
+
+void QMaterialWidget::updateAdaptiveQuality(qint64 paintNs)
+{
+    QualityState &quality = interaction().quality;
+
+    const qreal ms = paintNs / 1e6;
+    quality.averagePaintMs = quality.averagePaintMs > 0.0
+                                 ? quality.averagePaintMs * 0.75 + ms * 0.25
+                                 : ms;
+
+    if (quality.averagePaintMs <= config().paintBudgetMs) {
+        quality.overBudgetFrames = 0;
+        return;
+    }
+
+    // Понижаем уровень, только если бюджет превышен несколько кадров подряд
+    if (++quality.overBudgetFrames < 3 || quality.level == LowQuality)
+        return;
+
+    // Новый уровень оценивается с чистого листа
+    quality.overBudgetFrames = 0;
+    quality.averagePaintMs = 0.0;
+    setQualityLevel(QualityLevel(quality.level + 1));
 }
 
 void QMaterialWidget::setRippleEnabled(bool on)
 {
-    if (m_rippleEnabled == on)
+    if (config().rippleEnabled == on)
         return;
 
-    m_rippleEnabled = on;
-    if (!m_rippleEnabled) {
-        m_rippleTimer.stop();
-        m_rippleOpacity = 0.0;
-        update();
+    m_config->rippleEnabled = on;
+    if (!config().rippleEnabled && m_interaction && m_interaction->ripples.isActive()) {
+        updateRegion(rippleRegion());
+        m_interaction->ripples.clear();
     }
 }
 
+void QMaterialWidget::setRippleColor(const QColor &c)
+{
+    if (config().rippleColor == c)
+        return;
+
+    m_config->rippleColor = c;
+}
+
+void QMaterialWidget::setRippleOverflowPolicy(RippleOverflowPolicy policy)
+{
+    if (config().rippleOverflowPolicy == policy)
+        return;
+
+    m_config->rippleOverflowPolicy = policy;
+}
+
+void QMaterialWidget::setRippleRenderer(RippleRenderer renderer)
+{
+    if (config().rippleRenderer == renderer)
+        return;
+
+    const bool maskedBefore = usesCornerMask();
+    m_config->rippleRenderer = renderer;
+
+    // Маска формы строится вместе с фоном
+    if (usesCornerMask() != maskedBefore)
+        invalidateBackground();
+}
+
+void QMaterialWidget::setCornerClipMode(CornerClipMode mode)
+{
+    if (config().cornerClipMode == mode)
+        return;
+
+    m_config->cornerClipMode = mode;
+    invalidateBackground();
+    updateRegion(rect());
+}
+
+void QMaterialWidget::setLayerEnabled(bool on)
+{
+    if (config().layerEnabled == on)
+        return;
+
+    m_config->layerEnabled = on;
+    if (!config().layerEnabled)
+        releaseLayer();
+}
+
+void QMaterialWidget::captureLayer()
+{
+    if (!config().layerEnabled || !isVisible() || isLayerActive())
+        return;
+
+    QVector<QPointer<QWidget>> widgets;
+    const QList<QWidget *> descendants = findChildren<QWidget *>();
+    for (QWidget *w : descendants) {
+        if (w->isWindow())
+            continue;
+        // Такие дети рисуют поверх снимка сами или вне backing store карточки
+        if (w->autoFillBackground() || w->testAttribute(Qt::WA_OpaquePaintEvent)
+                || w->testAttribute(Qt::WA_NativeWindow) || w->graphicsEffect())
+            return;
+        widgets.append(w);
+    }
+
+    // Без детей кэшировать нечего
+    if (widgets.isEmpty())
+        return;
+
+    const qreal dpr = devicePixelRatioF();
+    QPixmap pixmap(QSize(qCeil(width() * dpr), qCeil(height() * dpr)));
+    pixmap.setDevicePixelRatio(dpr);
+    pixmap.fill(Qt::transparent);
+
+    // Только дети, без фона карточки: фон и ripple рисуются под снимком
+    const QList<QWidget *> children = findChildren<QWidget *>(QString(), Qt::FindDirectChildrenOnly);
+    for (QWidget *child : children) {
+        if (!child->isWindow() && child->isVisible())
+            child->render(&pixmap, child->pos(), QRegion(), QWidget::DrawChildren);
+    }
+
+    LayerState *layer = new LayerState;
+    layer->pixmap = pixmap;
+    layer->widgets = widgets;
+    for (QWidget *w : std::as_const(layer->widgets))
+        w->installEventFilter(this);
+    interaction().layer.reset(layer);
+}
+
+void QMaterialWidget::releaseLayer()
+{
+    if (!isLayerActive())
+        return;
+
+    QScopedPointer<LayerState> layer(m_interaction->layer.take());
+    for (const QPointer<QWidget> &w : std::as_const(layer->widgets)) {
+        if (w)
+            w->removeEventFilter(this);
+    }
+
+    // Пока действовал слой, дети могли измениться в перерисованной области
+    // незаметно для него: один раз перерисовываем их по-настоящему
+    updateRegion(layer->suppressed);
+}
+
+void QMaterialWidget::dropLayer()
+{
+    if (!isLayerActive())
+        return;
+
+    releaseLayer();
+    updateRegion(rect());
+}
+
+void QMaterialWidget::addLayerDamage(const QRegion &damage)
+{
+    if (isLayerActive())
+        m_interaction->layer->invalidated += damage;
+}
+
+void QMaterialWidget::childEvent(QChildEvent *event)
+{
+    if (event->added() || event->removed())
+        dropLayer();
+
+    QWidget::childEvent(event);
+}
+
+bool QMaterialWidget::eventFilter(QObject *watched, QEvent *event)
+{
+    // Фильтр стоит только на потомках, пока активен слой
+    if (watched == this || !isLayerActive())
+        return QWidget::eventFilter(watched, event);
+
+    switch (event->type()) {
+    case QEvent::Paint: {
+        QWidget *child = static_cast<QWidget *>(watched);
+        LayerState &layer = *m_interaction->layer;
+        const QRegion region = static_cast<QPaintEvent *>(event)->region()
+                                   .translated(child->mapTo(this, QPoint()));
+
+        // paintEvent карточки уже проверил, что весь кадр запрошен ею самой
+        // (иначе слой сброшен), и вывел эту область из снимка
+        if ((region - layer.frameDamage).isEmpty()) {
+            layer.suppressed += region;
+            return true;
+        }
+
+        // Ребёнок перерисовывается за пределами кадра карточки: снимок устарел
+        dropLayer();
+        break;
+    }
+    case QEvent::ChildAdded:
+    case QEvent::ChildRemoved:
+    case QEvent::Show:
+    case QEvent::Hide:
+    case QEvent::Move:
+    case QEvent::Resize:
+    case QEvent::StyleChange:
+    case QEvent::FontChange:
+    case QEvent::EnabledChange:
+    case QEvent::HoverEnter:
+    case QEvent::HoverLeave:
+    case QEvent::FocusIn:
+    case QEvent::FocusOut:
+    case QEvent::LayoutRequest:
+        dropLayer();
+        break;
+    default:
+        break;
+    }
+
+    return QWidget::eventFilter(watched, event);
+}
+
+void QMaterialWidget::setOpaqueUpdatesEnabled(bool on)
+{
+    if (config().opaqueUpdates == on)
+        return;
+
+    m_config->opaqueUpdates = on;
+    if (!config().opaqueUpdates)
+        clearOpaqueHint();
+}
+
+void QMaterialWidget::setAnimationThrottlingEnabled(bool on)
+{
+    if (config().animationThrottling == on)
+        return;
+
+    m_config->animationThrottling = on;
+}
+
 void QMaterialWidget::setCornerRadius(qreal r)
 {
-    if (qFuzzyCompare(m_cornerRadius, r))
+    if (qFuzzyCompare(config().cornerRadius, r))
         return;
 
-    m_cornerRadius = r;
-    update();
+    m_config->cornerRadius = r;
+    invalidateBackground();
+    updateCard();
 }
 
 void QMaterialWidget::setElevationStates(qreal rest, qreal hover, qreal pressed)
 {
-    m_restElevation   = rest;
-    m_hoverElevation  = hover;
-    m_pressedElevation = pressed;
+    m_config->restElevation   = rest;
+    m_config->hoverElevation  = hover;
+    m_config->pressedElevation = pressed;
+    updateAutoShadowMargins();
 
-    if (!m_elevationEnabled) {
+    if (!config().elevationEnabled) {
         m_elevation = 0.0;
-        update();
+        updateCard();
     }
 }
 
+void QMaterialWidget::setElevationStates(QMaterialElevationToken rest, QMaterialElevationToken hover,
+                                         QMaterialElevationToken pressed)
+{
+    setElevationStates(QMaterialElevation::elevation(rest), QMaterialElevation::elevation(hover),
+                       QMaterialElevation::elevation(pressed));
+}
+
 void QMaterialWidget::setShadowMargins(const QMargins &margins)
 {
-    if (m_shadowMargins == margins)
+    if (config().autoShadowMargins)
+        m_config->autoShadowMargins = false;
+
+    applyShadowMargins(margins);
+}
+
+void QMaterialWidget::applyShadowMargins(const QMargins &margins)
+{
+    if (config().shadowMargins == margins)
         return;
 
-    m_shadowMargins = margins;
+    m_config->shadowMargins = margins;
     applyEffectiveContentsMargins();
-    update();
+    invalidateBackground();
+    updateCard();
+}
+
+void QMaterialWidget::setAutoShadowMargins(bool on)
+{
+    if (config().autoShadowMargins == on)
+        return;
+
+    m_config->autoShadowMargins = on;
+    updateAutoShadowMargins();
+}
+
+QMargins QMaterialWidget::autoShadowMargins() const
+{
+    if (!config().shadowEnabled || !config().elevationEnabled)
+        return QMargins();
+
+    const qreal maxElevation = qMax(config().restElevation,
+                                    qMax(config().hoverElevation, config().pressedElevation));
+    if (maxElevation <= 0.0)
+        return QMargins();
+
+    // Размытие и смещение растут с elevation: хватает отступов наибольшего уровня.
+    // Стандартный уровень попадает в кэш без округления, запас на него не нужен.
+    if (const QMaterialElevationLevel *level = QMaterialElevation::find(maxElevation))
+        return level->margins;
+
+    return QMaterialShadowCache::shadowExtent(shadowSpec(maxElevation));
+}
+
+void QMaterialWidget::updateAutoShadowMargins()
+{
+    if (!config().autoShadowMargins || deferUpdate(PendingAutoMargins))
+        return;
+
+    applyShadowMargins(autoShadowMargins());
 }
 
 void QMaterialWidget::setContentsMargins(int left, int top, int right, int bottom)
@@ -140,55 +644,74 @@ void QMaterialWidget::setContentsMargins(int left, int top, int right, int botto
 
 void QMaterialWidget::setContentsMargins(const QMargins &margins)
 {
-    if (m_userContentsMargins == margins)
+    if (config().userContentsMargins == margins)
         return;
 
-    m_userContentsMargins = margins;
+    m_config->userContentsMargins = margins;
     applyEffectiveContentsMargins();
 }
 
 void QMaterialWidget::getContentsMargins(int *left, int *top, int *right, int *bottom) const
 {
     if (left) {
-        *left = m_userContentsMargins.left();
+        *left = config().userContentsMargins.left();
     }
     if (top) {
-        *top = m_userContentsMargins.top();
+        *top = config().userContentsMargins.top();
     }
     if (right) {
-        *right = m_userContentsMargins.right();
+        *right = config().userContentsMargins.right();
     }
     if (bottom) {
-        *bottom = m_userContentsMargins.bottom();
+        *bottom = config().userContentsMargins.bottom();
     }
 }
 
 QMargins QMaterialWidget::contentsMargins() const
 {
-    return m_userContentsMargins;
+    return config().userContentsMargins;
 }
 
 void QMaterialWidget::applyEffectiveContentsMargins()
 {
+    if (deferUpdate(PendingMargins))
+        return;
+
     QWidget::setContentsMargins(totalContentsMargins());
 }
 
 QMargins QMaterialWidget::totalContentsMargins() const
 {
+    const QMargins shadow = effectiveShadowMargins();
     return QMargins(
-        m_userContentsMargins.left() + m_shadowMargins.left(),
-        m_userContentsMargins.top() + m_shadowMargins.top(),
-        m_userContentsMargins.right() + m_shadowMargins.right(),
-        m_userContentsMargins.bottom() + m_shadowMargins.bottom());
+        config().userContentsMargins.left() + shadow.left(),
+        config().userContentsMargins.top() + shadow.top(),
+        config().userContentsMargins.right() + shadow.right(),
+        config().userContentsMargins.bottom() + shadow.bottom());
+}
+
+QMargins QMaterialWidget::effectiveShadowMargins() const
+{
+    // Тень размещённой карточки рисует поверхность, своё место под неё не нужно
+    return m_surface ? QMargins() : config().shadowMargins;
+}
+
+void QMaterialWidget::setShadowSurface(QMaterialSurface *surface)
+{
+    if (m_surface == surface)
+        return;
+
+    m_surface = surface;
+    applyEffectiveContentsMargins();
+    invalidateBackground();
+    updateRegion(rect());
 }
 
 QRectF QMaterialWidget::effectiveCardRect() const
 {
+    const QMargins shadow = effectiveShadowMargins();
     QRectF r = rect();
-    r.adjust(m_shadowMargins.left(),
-             m_shadowMargins.top(),
-             -m_shadowMargins.right(),
-             -m_shadowMargins.bottom());
+    r.adjust(shadow.left(), shadow.top(), -shadow.right(), -shadow.bottom());
 
     if (r.width() <= 0 || r.height() <= 0) {
         return QRectF(rect());
@@ -199,57 +722,116 @@ QRectF QMaterialWidget::effectiveCardRect() const
 
 void QMaterialWidget::startElevationAnimation(qreal target)
 {
-    if (!m_elevationEnabled) {
+    if (!config().elevationEnabled) {
         return;
     }
 
-    m_elevationAnim->stop();
-    m_elevationAnim->setStartValue(m_elevation);
-    m_elevationAnim->setEndValue(target);
-    m_elevationAnim->start();
+    // Невидимую карточку сразу переводим в конечное состояние, без кадров
+    if (config().animationThrottling && !isPresented()) {
+        stopElevationAnimation();
+        setElevation(target);
+        return;
+    }
+
+    interaction().elevationTransition.start(m_elevation, target);
+    captureLayer();
+    QMaterialAnimationDriver::instance()->start(this);
 }
 
-QPainterPath QMaterialWidget::cardClipPath(const QRectF &r) const
+void QMaterialWidget::stopElevationAnimation()
 {
-    QPainterPath path;
-    path.addRoundedRect(r, m_cornerRadius, m_cornerRadius);
-    return path;
+    // Драйвер сам отпишет виджет на следующем кадре, если анимировать больше нечего
+    if (m_interaction)
+        m_interaction->elevationTransition.stop();
 }
 
-void QMaterialWidget::paintShadow(QPainter &p, const QRectF &cardRect)
+void QMaterialWidget::finishAnimations()
 {
-    if (!m_shadowEnabled || !m_elevationEnabled || m_elevation <= 0.0)
+    if (!m_interaction)
         return;
 
-    p.save();
-
-    // Немного опустим тень вниз, имитируя "поднятие"
-    const qreal yOffset = m_elevation * 0.4;
-    const qreal blurRadius = 2.0 + m_elevation * 1.5;
-    const int steps = 8;
+    QMaterialElevationTransition &transition = m_interaction->elevationTransition;
+    if (transition.running) {
+        transition.stop();
+        setElevation(transition.to);
+    }
 
-    QColor baseColor(0, 0, 0);
-    baseColor.setAlpha(qBound(20, int(25 + m_elevation * 6), 130));
+    if (m_interaction->ripples.isActive()) {
+        updateRegion(rippleRegion());
+        m_interaction->ripples.clear();
+    }
+}
 
-    for (int i = 0; i < steps; ++i) {
-        const qreal t = qreal(i + 1) / steps;
-        const qreal grow = blurRadius * t;
+bool QMaterialWidget::isPresented() const
+{
+    // Скрыта сама карточка или её предок (например, неактивная вкладка QTabWidget)
+    if (!isVisible())
+        return false;
+
+    const QWidget *top = window();
+    if (top->isMinimized())
+        return false;
+
+    // Окно перекрыто или на другом рабочем столе — там, где платформа об этом сообщает
+    if (const QWindow *handle = top->windowHandle()) {
+        if (!handle->isExposed())
+            return false;
+    }
 
-        QRectF r = cardRect.adjusted(-grow, -grow, grow, grow);
-        r.translate(0, yOffset); // смещение вниз
+    // Прокручена за пределы QScrollArea или целиком обрезана родителями
+    return !visibleRegion().isEmpty();
+}
 
-        QColor c = baseColor;
-        c.setAlphaF(baseColor.alphaF() * (1.0 - t) * m_shadowIntensity);
+QPainterPath QMaterialWidget::cardClipPath(const QRectF &r) const
+{
+    QPainterPath path;
+    path.addRoundedRect(r, config().cornerRadius, config().cornerRadius);
+    return path;
+}
 
-        QPainterPath path;
-        path.addRoundedRect(r, m_cornerRadius + grow, m_cornerRadius + grow);
+bool QMaterialWidget::usesCornerMask() const
+{
+    // Спрайт выводится одним drawPixmap, и отсечение путём со сглаживанием
+    // стоило бы дороже самого круга, поэтому спрайты обрезаются маской
+    return config().cornerClipMode == MaskClip || config().rippleRenderer != EllipseRipple;
+}
 
-        p.setPen(Qt::NoPen);
-        p.setBrush(c);
-        p.drawPath(path);
+QMaterialShadowSpec QMaterialWidget::shadowSpec(qreal elevation) const
+{
+    QMaterialShadowSpec spec;
+    spec.cornerRadius = config().cornerRadius;
+    spec.elevation = elevation;
+    spec.intensity = config().shadowIntensity;
+    spec.engine = config().shadowEngine == AnalyticShadowEngine ? QMaterialShadowEngine::Analytic
+                                                         : QMaterialShadowEngine::Concentric;
+
+    switch (qualityLevel()) {
+    case FullQuality:
+        break;
+    case ReducedQuality:
+        spec.steps = 4;
+        break;
+    case LowQuality:
+        spec.steps = 2;
+        spec.antialiased = false;
+        break;
     }
+    return spec;
+}
 
-    p.restore();
+void QMaterialWidget::paintShadow(QPainter &p, const QRectF &cardRect)
+{
+    if (!config().shadowEnabled || !config().elevationEnabled || m_elevation <= 0.0)
+        return;
+
+    const QMaterialShadowSpec spec = shadowSpec(m_elevation);
+
+    // Тень берётся из общего кэша: в установившемся состоянии это один drawPixmap
+    if (config().shadowMode == NinePatchShadow) {
+        QMaterialShadowCache::instance()->paintNinePatchShadow(p, cardRect, spec);
+    } else {
+        QMaterialShadowCache::instance()->paintShadow(p, cardRect, spec);
+    }
 }
 
 void QMaterialWidget::paintBackground(QPainter &p, const QRectF &cardRect)
@@ -261,7 +843,7 @@ void QMaterialWidget::paintBackground(QPainter &p, const QRectF &cardRect)
     opt.rect = cardRect.toRect();
     
     // Временно включаем WA_StyledBackground для правильного чтения QSS стилей
-    // Но рисуем только в области карточки благодаря clipping в paintEvent
+    // Но рисуем только в области карточки благодаря clipping в renderBackground
     bool hadStyledBackground = testAttribute(Qt::WA_StyledBackground);
     setAttribute(Qt::WA_StyledBackground, true);
     
@@ -273,59 +855,690 @@ void QMaterialWidget::paintBackground(QPainter &p, const QRectF &cardRect)
     setAttribute(Qt::WA_StyledBackground, hadStyledBackground);
 }
 
+void QMaterialWidget::paintRipples(QPainter &p, const QRectF &cardRect, qreal dpr, const QImage &mask)
+{
+    const QMaterialRipplePool<MaxRipples> &ripples = m_interaction->ripples;
+    const QColor color = config().rippleColor;
+    const QMaterialRippleRenderer renderer = config().rippleRenderer == SpriteRipple
+        ? QMaterialRippleRenderer::Sprite
+        : config().rippleRenderer == SoftSpriteRipple ? QMaterialRippleRenderer::SoftSprite
+                                                      : QMaterialRippleRenderer::Ellipse;
+
+    p.save();
+    p.setRenderHint(QPainter::Antialiasing, qualityLevel() == FullQuality);
+
+    if (!usesCornerMask()) {
+        p.setClipPath(cardClipPath(cardRect));
+        ripples.paint(p, color, renderer);
+        p.restore();
+        return;
+    }
+
+    const QRect card = cardRect.toAlignedRect();
+    const QRect bounds = ripples.boundingRegion(cardRect).boundingRect() & card;
+    const int corner = qCeil(config().cornerRadius);
+
+    // Ripple, не задевающие скруглённые углы, обрезаются прямоугольником
+    const QSize cornerSize(corner, corner);
+    const bool reachesCorner = corner > 0
+        && (bounds.intersects(QRect(card.topLeft(), cornerSize))
+            || bounds.intersects(QRect(QPoint(card.right() - corner + 1, card.top()), cornerSize))
+            || bounds.intersects(QRect(QPoint(card.left(), card.bottom() - corner + 1), cornerSize))
+            || bounds.intersects(QRect(QPoint(card.right() - corner + 1, card.bottom() - corner + 1), cornerSize)));
+
+    if (!reachesCorner || mask.isNull()) {
+        p.setClipRect(card);
+        ripples.paint(p, color, renderer);
+        p.restore();
+        return;
+    }
+
+    // Иначе ripple рисуются в слой размером с их область, слой обрезается
+    // маской карточки (DestinationIn) и выводится одним drawImage
+    const QSize pixels(qCeil(bounds.width() * dpr), qCeil(bounds.height() * dpr));
+    QImage &layer = rippleLayer(pixels, dpr);
+
+    QPainter lp(&layer);
+    lp.setCompositionMode(QPainter::CompositionMode_Source);
+    lp.fillRect(QRectF(QPointF(0, 0), QSizeF(pixels) / dpr), Qt::transparent);
+    lp.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    lp.setRenderHint(QPainter::Antialiasing, qualityLevel() == FullQuality);
+    lp.translate(-bounds.topLeft());
+    ripples.paint(lp, color, renderer);
+    lp.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+    lp.drawImage(card.topLeft(), mask);
+    lp.end();
+
+    p.drawImage(QRectF(bounds), layer, QRectF(QPointF(0, 0), QSizeF(pixels)));
+    p.restore();
+}
+
+bool QMaterialWidget::isDamageDebugEnabled()
+{
+    return s_damageDebug;
+}
+
+void QMaterialWidget::setDamageDebugEnabled(bool on)
+{
+    s_damageDebug = on;
+}
+
+void QMaterialWidget::paintDamageDebug(QPainter &p, const QRegion &region)
+{
+    qint64 pixels = 0;
+    p.save();
+    p.setRenderHint(QPainter::Antialiasing, false);
+    p.setPen(QColor(255, 0, 0, 200));
+    p.setBrush(QColor(255, 0, 0, 40));
+    for (const QRect &r : region) {
+        pixels += qint64(r.width()) * r.height();
+        p.drawRect(r.adjusted(0, 0, -1, -1));
+    }
+    p.restore();
+
+    qCDebug(lcMaterialDamage) << this << "rects:" << region.rectCount() << "pixels:" << pixels;
+}
+
+bool QMaterialWidget::isStatisticsEnabled()
+{
+    return statisticsState().enabled;
+}
+
+void QMaterialWidget::setStatisticsEnabled(bool on)
+{
+    statisticsState().enabled = on;
+    updateLogTimer();
+}
+
+QMaterialWidget::PaintStatistics &QMaterialWidget::ensureStatistics()
+{
+    if (!m_statistics) {
+        m_statistics.reset(new StatisticsData);
+        statisticsState().instances.insert(this);
+        updateLogTimer();
+    }
+    return m_statistics->stats;
+}
+
+void QMaterialWidget::recordPaint(qint64 shadowNs, qint64 backgroundNs, qint64 rippleNs, qint64 totalNs)
+{
+    PaintStatistics &local = ensureStatistics();
+    PaintStatistics &global = statisticsState().global;
+
+    for (PaintStatistics *stats : { &local, &global }) {
+        ++stats->paintCount;
+        recordPhase(stats->paint, totalNs);
+        recordPhase(stats->shadow, shadowNs);
+        recordPhase(stats->background, backgroundNs);
+        recordPhase(stats->ripple, rippleNs);
+    }
+}
+
+void QMaterialWidget::recordAnimationTick(qreal dtMs)
+{
+    PaintStatistics &local = ensureStatistics();
+    ++local.animationTicks;
+    m_statistics->animatedMs += dtMs;
+}
+
+QMaterialWidget::PaintStatistics QMaterialWidget::statistics() const
+{
+    if (!m_statistics)
+        return PaintStatistics();
+
+    PaintStatistics stats = m_statistics->stats;
+    if (m_statistics->animatedMs > 0.0)
+        stats.animationTicksPerSecond = stats.animationTicks * 1000.0 / m_statistics->animatedMs;
+    return stats;
+}
+
+void QMaterialWidget::resetStatistics()
+{
+    if (m_statistics)
+        *m_statistics = StatisticsData();
+}
+
+QMaterialWidget::PaintStatistics QMaterialWidget::globalStatistics()
+{
+    // Тики считаются по кадрам общего драйвера, а не по карточкам
+    PaintStatistics stats = statisticsState().global;
+    const QMaterialAnimationDriver *driver = QMaterialAnimationDriver::instance();
+    stats.animationTicks = driver->frameCount();
+    if (driver->activeMs() > 0.0)
+        stats.animationTicksPerSecond = driver->frameCount() * 1000.0 / driver->activeMs();
+    return stats;
+}
+
+void QMaterialWidget::resetGlobalStatistics()
+{
+    statisticsState().global = PaintStatistics();
+    QMaterialAnimationDriver::instance()->resetStatistics();
+}
+
+int QMaterialWidget::statisticsLogInterval()
+{
+    return statisticsState().logIntervalMs;
+}
+
+void QMaterialWidget::setStatisticsLogInterval(int ms)
+{
+    statisticsState().logIntervalMs = qMax(0, ms);
+    updateLogTimer();
+}
+
+void QMaterialWidget::logStatisticsSummary()
+{
+    const PaintStatistics global = globalStatistics();
+    if (global.paintCount == 0)
+        return;
+
+    qCInfo(lcMaterialStats).nospace()
+        << "paints: " << global.paintCount
+        << ", paintEvent " << global.paint
+        << ", shadow " << global.shadow
+        << ", background " << global.background
+        << ", ripple " << global.ripple
+        << ", animation ticks/s: " << global.animationTicksPerSecond;
+
+    // Самые дорогие карточки вместе с их конфигурацией
+    QList<QMaterialWidget *> widgets = statisticsState().instances.values();
+    std::sort(widgets.begin(), widgets.end(), [](QMaterialWidget *a, QMaterialWidget *b) {
+        return a->m_statistics->stats.paint.totalNs > b->m_statistics->stats.paint.totalNs;
+    });
+
+    const int top = qMin(5, int(widgets.size()));
+    for (int i = 0; i < top; ++i) {
+        const QMaterialWidget *w = widgets.at(i);
+        const PaintStatistics stats = w->statistics();
+        if (stats.paintCount == 0)
+            break;
+
+        qCInfo(lcMaterialStats).nospace()
+            << "  " << w->objectName() << ' ' << w->size()
+            << " radius " << w->config().cornerRadius
+            << " elevation " << w->config().restElevation << '/' << w->config().hoverElevation << '/' << w->config().pressedElevation
+            << ' ' << w->config().shadowMode << ' ' << w->config().shadowEngine
+            << ": paints " << stats.paintCount
+            << ", avg " << stats.paint.totalNs / 1e6 / stats.paintCount << " ms"
+            << ", max " << stats.paint.maxNs / 1e6 << " ms"
+            << ", shadow " << stats.shadow.totalNs / 1e6 << " ms"
+            << ", background " << stats.background.totalNs / 1e6 << " ms"
+            << ", ripple " << stats.ripple.totalNs / 1e6 << " ms";
+    }
+}
+
+QRect QMaterialWidget::shadowRect(qreal elevation) const
+{
+    if (!config().shadowEnabled || !config().elevationEnabled || elevation <= 0.0)
+        return QRect();
+
+    // +1 пиксель: кэш квантует elevation и может немного увеличить отступ
+    const QMargins pad = QMaterialShadowCache::shadowPadding(shadowSpec(elevation)) + 1;
+    return effectiveCardRect().toAlignedRect().marginsAdded(pad);
+}
+
+QRegion QMaterialWidget::rippleRegion() const
+{
+    return m_interaction ? m_interaction->ripples.boundingRegion(effectiveCardRect()) : QRegion();
+}
+
+QRegion QMaterialWidget::opaqueInteriorRegion(const QRectF &cardRect) const
+{
+    // Карточка без скруглённых углов и сглаженного края (1 пиксель)
+    const QRect card = cardRect.toAlignedRect().adjusted(1, 1, -1, -1);
+    const int corner = qCeil(config().cornerRadius);
+
+    QRegion region(card.adjusted(corner, 0, -corner, 0));
+    region += card.adjusted(0, corner, 0, -corner);
+    return region;
+}
+
+void QMaterialWidget::invalidateBackground()
+{
+    if (m_background)
+        m_background->valid = false;
+
+    // Признак непрозрачности выводится из фона и вернётся при следующей отрисовке
+    clearOpaqueHint();
+}
+
+int QMaterialWidget::backgroundState() const
+{
+    QStyleOption opt;
+    opt.initFrom(this);
+    return int(opt.state);
+}
+
+bool QMaterialWidget::isBackgroundCacheCurrent(const QSize &size, int state) const
+{
+    // Состояние стиля входит в ключ, чтобы псевдоклассы QSS (:hover, :disabled) работали.
+    // При его смене устаревают изображения для всех devicePixelRatio.
+    return m_background && m_background->valid
+           && m_background->size == size
+           && m_background->paletteKey == palette().cacheKey()
+           && m_background->state == state
+           && m_background->styleSheet == styleSheet();
+}
+
+const QMaterialWidget::BackgroundAsset &QMaterialWidget::backgroundAsset(const QRectF &cardRect, qreal dpr)
+{
+    const QSize size = cardRect.toAlignedRect().size();
+    const int state = backgroundState();
+
+    // Кэш создаётся при первой отрисовке: карточки за пределами экрана его не держат
+    if (!m_background)
+        m_background.reset(new BackgroundCache);
+    BackgroundCache &cache = *m_background;
+
+    if (!isBackgroundCacheCurrent(size, state)) {
+        cache.size = size;
+        cache.paletteKey = palette().cacheKey();
+        cache.state = state;
+        cache.styleSheet = styleSheet();
+        cache.assets.clear();
+        cache.valid = true;
+    }
+
+    const int ratioKey = qRound(dpr * 100.0);
+    auto it = cache.assets.find(ratioKey);
+    if (it == cache.assets.end()) {
+        // Экранов с разными коэффициентами обычно два-три; больше не держим
+        if (cache.assets.size() >= MaxBackgroundRatios)
+            cache.assets.erase(cache.assets.begin());
+        it = cache.assets.insert(ratioKey, renderBackground(cardRect, dpr));
+    }
+
+    return it.value();
+}
+
+QMaterialWidget::BackgroundAsset QMaterialWidget::renderBackground(const QRectF &cardRect, qreal dpr)
+{
+    const QRect card = cardRect.toAlignedRect();
+    BackgroundAsset asset;
+
+    QImage image(QSize(qCeil(card.width() * dpr), qCeil(card.height() * dpr)),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    image.fill(Qt::transparent);
+
+    // Фон сразу обрезается по скруглению, поэтому при выводе клип не нужен
+    QPainter p(&image);
+    p.setRenderHint(QPainter::Antialiasing, true);
+    p.translate(-card.topLeft());
+
+    if (usesCornerMask()) {
+        // Маска формы карточки: ею же обрезаются ripple, задевающие углы
+        QImage mask(image.size(), QImage::Format_ARGB32_Premultiplied);
+        mask.setDevicePixelRatio(dpr);
+        mask.fill(Qt::transparent);
+
+        QPainter mp(&mask);
+        mp.setRenderHint(QPainter::Antialiasing, true);
+        mp.translate(-card.topLeft());
+        mp.fillPath(cardClipPath(cardRect), Qt::black);
+        mp.end();
+
+        paintBackground(p, cardRect);
+        p.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+        p.drawImage(card.topLeft(), mask);
+        asset.mask = mask;
+    } else {
+        p.setClipPath(cardClipPath(cardRect));
+        paintBackground(p, cardRect);
+    }
+    p.end();
+
+    // Заодно проверяем, непрозрачен ли фон внутри карточки
+    const QRegion interior = opaqueInteriorRegion(cardRect).translated(-card.topLeft());
+    bool opaque = !interior.isEmpty();
+
+    for (const QRect &r : interior) {
+        const QRect pixels = QRectF(QPointF(r.topLeft()) * dpr, QSizeF(r.size()) * dpr).toAlignedRect()
+                             & image.rect();
+        for (int y = pixels.top(); y <= pixels.bottom() && opaque; ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            for (int x = pixels.left(); x <= pixels.right(); ++x) {
+                if (qAlpha(line[x]) != 255) {
+                    opaque = false;
+                    break;
+                }
+            }
+        }
+        if (!opaque)
+            break;
+    }
+
+    // Сплошной фон закрашивает и сглаженный край, и углы
+    bool filled = opaque;
+    for (int y = 0; y < image.height() && filled; ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            if (qAlpha(line[x]) != 255) {
+                filled = false;
+                break;
+            }
+        }
+    }
+
+    asset.opaque = opaque;
+    asset.filled = filled;
+    asset.pixmap = QPixmap::fromImage(image);
+    return asset;
+}
+
+bool QMaterialWidget::isBackgroundOpaque() const
+{
+    // Ответ берётся только из уже отрисованного фона: растеризовать его ради
+    // проверки из сеттера или шага анимации, да ещё до первой отрисовки, дорого.
+    // Пока фон не отрисован для текущих стиля, размера и коэффициента, ответ
+    // осторожный: фон считается прозрачным и перерисовывается тень целиком.
+    if (!isBackgroundCacheCurrent(effectiveCardRect().toAlignedRect().size(), backgroundState()))
+        return false;
+
+    const auto it = m_background->assets.constFind(qRound(devicePixelRatioF() * 100.0));
+    return it != m_background->assets.constEnd() && it->opaque;
+}
+
+void QMaterialWidget::prepareDevicePixelRatio()
+{
+    if (!isVisible())
+        return;
+
+    // Окно перешло на экран с другим коэффициентом: тени растеризуются заранее
+    // в фоновых потоках, а фон — один раз сейчас, если карточка уже рисовалась.
+    // Изображения прежнего коэффициента остаются в кэшах для обратного переноса.
+    prewarmShadows();
+    if (m_background && m_background->valid) {
+        const QRectF cardRect = effectiveCardRect();
+        if (!cardRect.isEmpty())
+            backgroundAsset(cardRect, devicePixelRatioF());
+    }
+}
+
+bool QMaterialWidget::event(QEvent *event)
+{
+    const bool result = QWidget::event(event);
+
+    switch (event->type()) {
+    case QEvent::LayoutRequest:
+        // Подсказка размера ребёнка изменилась (например, setText у QLabel)
+        dropLayer();
+        break;
+    case QEvent::ScreenChangeInternal:
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    case QEvent::DevicePixelRatioChange:
+#endif
+        prepareDevicePixelRatio();
+        break;
+    default:
+        break;
+    }
+
+    return result;
+}
+
+void QMaterialWidget::updateShadow(qreal previousElevation)
+{
+    // Тень размещённой карточки лежит на поверхности
+    if (m_surface) {
+        m_surface->updateCardShadow(this);
+        return;
+    }
+
+    QRegion damage(shadowRect(previousElevation));
+    damage += shadowRect(m_elevation);
+    if (damage.isEmpty())
+        return;
+
+    // Под непрозрачным фоном тень не видна: перерисовываем только кольцо вокруг карточки
+    if (isBackgroundOpaque())
+        damage -= opaqueInteriorRegion(effectiveCardRect());
+
+    updateRegion(damage);
+}
+
+void QMaterialWidget::updateRegion(const QRegion &damage)
+{
+    if (damage.isEmpty() || deferUpdate(PendingRepaint))
+        return;
+
+    addLayerDamage(damage);
+    update(damage);
+}
+
+void QMaterialWidget::updateCard()
+{
+    if (deferUpdate(PendingRepaint))
+        return;
+
+    if (m_surface)
+        m_surface->updateCardShadow(this);
+    updateRegion(rect());
+}
+
+void QMaterialWidget::updateOpaqueHint(const BackgroundAsset &background)
+{
+    // WA_OpaquePaintEvent обещает Qt, что виджет сам закрашивает весь свой
+    // прямоугольник, и Qt не рисует под ним родителя ни в одной области кадра,
+    // в том числе запрошенной соседями. Поэтому признак ставится, только когда
+    // карточка занимает весь виджет (без отступов под тень) и её фон сплошной,
+    // без прозрачных скруглённых углов, а тень под ней не рисует поверхность.
+    const bool opaque = config().opaqueUpdates && !m_surface && background.filled
+                        && effectiveCardRect() == QRectF(rect());
+    if (testAttribute(Qt::WA_OpaquePaintEvent) == opaque)
+        return;
+
+    setAttribute(Qt::WA_OpaquePaintEvent, opaque);
+
+    // Этот кадр уже выведен поверх нетронутого родителя: повторяем его с родителем
+    if (!opaque)
+        update();
+}
+
+void QMaterialWidget::clearOpaqueHint()
+{
+    if (testAttribute(Qt::WA_OpaquePaintEvent))
+        setAttribute(Qt::WA_OpaquePaintEvent, false);
+}
+
+void QMaterialWidget::beginUpdate()
+{
+    ++m_updateDepth;
+}
+
+void QMaterialWidget::commitUpdate()
+{
+    Q_ASSERT_X(m_updateDepth > 0, "QMaterialWidget::commitUpdate", "commitUpdate without beginUpdate");
+    if (m_updateDepth == 0 || --m_updateDepth > 0)
+        return;
+
+    // Внутри глобальной транзакции всё применится в commitGlobalUpdate()
+    if (transactionState().depth > 0) {
+        if (m_pendingUpdates)
+            registerGlobalUpdate();
+        return;
+    }
+
+    flushPendingUpdates();
+}
+
+void QMaterialWidget::beginGlobalUpdate()
+{
+    ++transactionState().depth;
+}
+
+void QMaterialWidget::commitGlobalUpdate()
+{
+    TransactionState &transaction = transactionState();
+    Q_ASSERT_X(transaction.depth > 0, "QMaterialWidget::commitGlobalUpdate",
+               "commitGlobalUpdate without beginGlobalUpdate");
+    if (transaction.depth == 0 || --transaction.depth > 0)
+        return;
+
+    const QVector<QPointer<QMaterialWidget>> widgets = std::move(transaction.widgets);
+    transaction.widgets.clear();
+
+    for (const QPointer<QMaterialWidget> &widget : widgets) {
+        if (!widget)
+            continue;
+
+        widget->m_pendingUpdates &= quint8(~PendingGlobal);
+        // Карточка в своей транзакции применит всё в своём commitUpdate()
+        if (widget->m_updateDepth == 0)
+            widget->flushPendingUpdates();
+    }
+}
+
+bool QMaterialWidget::isGlobalUpdating()
+{
+    return transactionState().depth > 0;
+}
+
+bool QMaterialWidget::deferUpdate(PendingUpdate update)
+{
+    if (m_updateDepth == 0 && transactionState().depth == 0)
+        return false;
+
+    m_pendingUpdates |= update;
+    if (transactionState().depth > 0)
+        registerGlobalUpdate();
+    return true;
+}
+
+void QMaterialWidget::registerGlobalUpdate()
+{
+    if (m_pendingUpdates & PendingGlobal)
+        return;
+
+    m_pendingUpdates |= PendingGlobal;
+    transactionState().widgets.append(this);
+}
+
+void QMaterialWidget::flushPendingUpdates()
+{
+    const quint8 pending = m_pendingUpdates;
+    m_pendingUpdates = 0;
+
+    // Автоматические отступы сами пересчитают отступы и перерисуют карточку,
+    // если изменились; повторный setContentsMargins с теми же значениями Qt пропускает
+    if (pending & PendingAutoMargins)
+        updateAutoShadowMargins();
+    if (pending & PendingMargins)
+        applyEffectiveContentsMargins();
+    if (pending & PendingRepaint)
+        updateCard();
+}
+
+void QMaterialWidget::resizeEvent(QResizeEvent *event)
+{
+    // Новую площадь Qt должен закрасить вместе с родителем
+    clearOpaqueHint();
+    dropLayer();
+    invalidateBackground();
+    QWidget::resizeEvent(event);
+}
+
+void QMaterialWidget::changeEvent(QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::StyleChange:
+    case QEvent::PaletteChange:
+        invalidateBackground();
+        dropLayer();
+        break;
+    case QEvent::FontChange:
+    case QEvent::EnabledChange:
+        dropLayer();
+        break;
+    default:
+        break;
+    }
+
+    QWidget::changeEvent(event);
+}
+
 void QMaterialWidget::paintEvent(QPaintEvent *event)
 {
-    Q_UNUSED(event);
+    // Замеры фаз только при включённой статистике; адаптивному качеству
+    // нужны лишь кадры анимаций
+    const bool statistics = statisticsState().enabled;
+    const bool adaptive = config().adaptiveQuality && !isQualityLevelPinned()
+                          && QMaterialAnimationDriver::instance()->isAnimating(this);
+    const QualityLevel quality = qualityLevel();
+    const bool measure = statistics || adaptive;
+    QElapsedTimer timer;
+    if (measure)
+        timer.start();
+
+    // Кадр, часть которого запросила не карточка, — это update() самих детей
+    // (setText, шаг QProgressBar, курсор) или их раскрытие: содержимое
+    // изменилось, и снимок выводить нельзя. Дети в этом кадре рисуются сами.
+    if (isLayerActive() && !(event->region() - m_interaction->layer->invalidated).isEmpty())
+        dropLayer();
 
     QPainter p(this);
-    p.setRenderHint(QPainter::Antialiasing, true);
+    p.setRenderHint(QPainter::Antialiasing, quality != LowQuality);
 
     // Немного отступим от краёв, чтобы тень и скругление не обрезались
     QRectF cardRect = effectiveCardRect();
     if (cardRect.isEmpty())
         return;
 
-    // 1) Тень (под карточкой)
-    paintShadow(p, cardRect);
+    // 1) Тень (под карточкой); у размещённой на QMaterialSurface её рисует поверхность
+    if (!m_surface)
+        paintShadow(p, cardRect);
+    const qint64 shadowDoneNs = measure ? timer.nsecsElapsed() : 0;
 
-    // 2) Фон и бордеры из styleSheet / QStyle (только внутри области карточки)
-    p.save();
-    p.setClipPath(cardClipPath(cardRect));
-    paintBackground(p, cardRect);
-    p.restore();
+    // 2) Фон и бордеры из styleSheet / QStyle (только внутри области карточки).
+    //    Берутся из кэша, который перестраивается при смене стиля, палитры и размера
+    const qreal dpr = p.device() ? p.device()->devicePixelRatioF() : devicePixelRatioF();
+    const BackgroundAsset &background = backgroundAsset(cardRect, dpr);
+    p.drawPixmap(cardRect.toAlignedRect().topLeft(), background.pixmap);
+    updateOpaqueHint(background);
+    const qint64 backgroundDoneNs = measure ? timer.nsecsElapsed() : 0;
 
     // Дальше Qt сам нарисует детей (QLabel, QLayout и т.п.)
 
     // 3) Ripple-эффект поверх фона (под детьми с непрозрачным фоном)
-    if (m_rippleEnabled && m_rippleOpacity > 0.0) {
-        p.save();
-        p.setClipPath(cardClipPath(cardRect));
-
-        QColor c = m_rippleColor;
-        c.setAlphaF(c.alphaF() * m_rippleOpacity);
-
-        p.setPen(Qt::NoPen);
-        p.setBrush(c);
-        p.drawEllipse(m_rippleCenter, m_rippleRadius, m_rippleRadius);
+    //    Все ripple рисуются за один проход с одним отсечением
+    if (config().rippleEnabled && m_interaction && m_interaction->ripples.isActive())
+        paintRipples(p, cardRect, dpr, background.mask);
+
+    // 4) Слой: дети выводятся из снимка, их собственная отрисовка подавляется
+    if (m_interaction && m_interaction->layer) {
+        m_interaction->layer->frameDamage = event->region();
+        m_interaction->layer->invalidated -= event->region();
+        p.drawPixmap(0, 0, m_interaction->layer->pixmap);
+    }
 
-        p.restore();
+    if (measure) {
+        const qint64 rippleDoneNs = timer.nsecsElapsed();
+        if (statistics) {
+            recordPaint(shadowDoneNs, backgroundDoneNs - shadowDoneNs,
+                        rippleDoneNs - backgroundDoneNs, rippleDoneNs);
+        }
+        if (adaptive)
+            updateAdaptiveQuality(rippleDoneNs);
     }
+
+    if (s_damageDebug)
+        paintDamageDebug(p, event->region());
 }
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 void QMaterialWidget::enterEvent(QEnterEvent *event)
 {
     QWidget::enterEvent(event);
-    if (m_elevationEnabled) {
-        startElevationAnimation(m_hoverElevation);
+    if (config().elevationEnabled) {
+        startElevationAnimation(config().hoverElevation);
     }
 }
 #else
 void QMaterialWidget::enterEvent(QEvent *event)
 {
     QWidget::enterEvent(event);
-    if (m_elevationEnabled) {
-        startElevationAnimation(m_hoverElevation);
+    if (config().elevationEnabled) {
+        startElevationAnimation(config().hoverElevation);
     }
 }
 #endif
@@ -333,41 +1546,30 @@ void QMaterialWidget::enterEvent(QEvent *event)
 void QMaterialWidget::leaveEvent(QEvent *event)
 {
     QWidget::leaveEvent(event);
-    if (m_elevationEnabled) {
-        startElevationAnimation(m_restElevation);
+    if (config().elevationEnabled) {
+        startElevationAnimation(config().restElevation);
     }
 }
 
 void QMaterialWidget::mousePressEvent(QMouseEvent *event)
 {
     const QRectF card = effectiveCardRect();
-    m_mousePressedInside = card.contains(event->pos());
+    InteractionState &state = interaction();
+    state.mousePressedInside = card.contains(event->pos());
 
-    if (m_elevationEnabled) {
-        startElevationAnimation(m_pressedElevation);
+    if (config().elevationEnabled) {
+        startElevationAnimation(config().pressedElevation);
     }
 
-    if (m_rippleEnabled && m_mousePressedInside) {
-        // Начинаем ripple
-        m_rippleCenter = event->pos();
-        m_rippleRadius = 0.0;
-        m_rippleOpacity = 1.0;
-
-        // Максимальный радиус — до самого дальнего угла
-        const QPointF topLeft = card.topLeft();
-        const QPointF topRight = card.topRight();
-        const QPointF bottomLeft = card.bottomLeft();
-        const QPointF bottomRight = card.bottomRight();
-
-        qreal d1 = QLineF(m_rippleCenter, topLeft).length();
-        qreal d2 = QLineF(m_rippleCenter, topRight).length();
-        qreal d3 = QLineF(m_rippleCenter, bottomLeft).length();
-        qreal d4 = QLineF(m_rippleCenter, bottomRight).length();
-
-        m_rippleMaxRadius = qMax(qMax(d1, d2), qMax(d3, d4));
-
-        if (!m_rippleTimer.isActive())
-            m_rippleTimer.start();
+    if (config().rippleEnabled && state.mousePressedInside) {
+        // Новый ripple добавляется к уже идущим; при переполнении пула
+        // вытесненный круг нужно стереть
+        const QRegion before = rippleRegion();
+        if (state.ripples.start(event->pos(), card, rippleOverflow())) {
+            updateRegion(before | rippleRegion());
+            captureLayer();
+            QMaterialAnimationDriver::instance()->start(this);
+        }
     }
 
     QWidget::mousePressEvent(event);
@@ -376,15 +1578,16 @@ void QMaterialWidget::mousePressEvent(QMouseEvent *event)
 void QMaterialWidget::mouseReleaseEvent(QMouseEvent *event)
 {
     const QRectF card = effectiveCardRect();
-    const bool wasPressedInside = m_mousePressedInside;
-    m_mousePressedInside = false;
+    const bool wasPressedInside = m_interaction && m_interaction->mousePressedInside;
+    if (m_interaction)
+        m_interaction->mousePressedInside = false;
 
-    if (m_elevationEnabled) {
+    if (config().elevationEnabled) {
         // Если мышь всё ещё над виджетом — вернёмся к hover
         if (card.contains(event->pos())) {
-            startElevationAnimation(m_hoverElevation);
+            startElevationAnimation(config().hoverElevation);
         } else {
-            startElevationAnimation(m_restElevation);
+            startElevationAnimation(config().restElevation);
         }
     }
 
@@ -395,31 +1598,73 @@ void QMaterialWidget::mouseReleaseEvent(QMouseEvent *event)
     QWidget::mouseReleaseEvent(event);
 }
 
-void QMaterialWidget::updateRipple()
+bool QMaterialWidget::advanceAnimations(qreal dtMs)
 {
-    if (!m_rippleEnabled) {
-        m_rippleTimer.stop();
-        return;
+    if (statisticsState().enabled)
+        recordAnimationTick(dtMs);
+
+    bool animating = false;
+    if (config().animationThrottling && !isPresented()) {
+        // Карточку не видно: кадры не нужны, драйвер её отпишет
+        finishAnimations();
+    } else {
+        // Оба шага выполняются всегда, поэтому без короткого замыкания
+        const bool elevationActive = updateElevationAnimation(dtMs);
+        const bool rippleActive = updateRipple(dtMs);
+        animating = elevationActive || rippleActive;
     }
 
-    if (m_rippleOpacity <= 0.0) {
-        m_rippleTimer.stop();
-        m_rippleOpacity = 0.0;
-        update();
-        return;
+    if (!animating)
+        releaseLayer();
+
+    // В покое бюджет не важен: возвращаем полное качество
+    if (!animating && m_interaction && !m_interaction->quality.pinned) {
+        m_interaction->quality.averagePaintMs = 0.0;
+        m_interaction->quality.overBudgetFrames = 0;
+        setQualityLevel(FullQuality);
     }
 
-    const qreal dt = qreal(m_rippleTimer.interval()) / m_rippleDurationMs;
-    m_rippleRadius += m_rippleMaxRadius * dt;
-    m_rippleOpacity -= dt;
+    return animating;
+}
 
-    if (m_rippleRadius >= m_rippleMaxRadius) {
-        m_rippleOpacity -= dt * 2.0; // чуть быстрее затухаем в конце
+bool QMaterialWidget::updateElevationAnimation(qreal dtMs)
+{
+    if (!m_interaction || !m_interaction->elevationTransition.running)
+        return false;
+
+    QMaterialElevationTransition &transition = m_interaction->elevationTransition;
+    setElevation(transition.advance(dtMs));
+    return transition.running;
+}
+
+QMaterialRippleOverflow QMaterialWidget::rippleOverflow() const
+{
+    switch (config().rippleOverflowPolicy) {
+    case ReplaceFaintestRipple:
+        return QMaterialRippleOverflow::ReplaceFaintest;
+    case IgnoreNewRipple:
+        return QMaterialRippleOverflow::IgnoreNew;
+    case DropOldestRipple:
+        break;
     }
+    return QMaterialRippleOverflow::DropOldest;
+}
+
+bool QMaterialWidget::updateRipple(qreal dtMs)
+{
+    if (!m_interaction || !m_interaction->ripples.isActive())
+        return false;
 
-    if (m_rippleOpacity < 0.0) {
-        m_rippleOpacity = 0.0;
+    if (!config().rippleEnabled) {
+        updateRegion(rippleRegion());
+        m_interaction->ripples.clear();
+        return false;
     }
 
-    update();
+    // Все ripple продвигаются одним проходом; перерисовываем только их круги
+    // до шага и после (они растут от центра)
+    const QRegion before = rippleRegion();
+    const bool active = m_interaction->ripples.advance(dtMs, config().rippleDurationMs);
+    updateRegion(before | rippleRegion());
+    return active;
 }
@@ -1,14 +1,28 @@
 #pragma once
 
+#include "QMaterialAnimation.h"
+#include "QMaterialAnimationDriver.h"
+#include "QMaterialElevation.h"
+#include "QMaterialShadowCache.h"
+
 #include <QWidget>
 #include <QColor>
-#include <QPropertyAnimation>
-#include <QTimer>
+#include <QHash>
+#include <QImage>
 #include <QPainterPath>
+#include <QPixmap>
+#include <QPointer>
 #include <QMargins>
+#include <QRegion>
+#include <QScopedPointer>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QVector>
 #include <QtGlobal>
 
-class QMaterialWidget : public QWidget
+class QMaterialSurface;
+
+class QMaterialWidget : public QWidget, public QMaterialAnimationTarget
 {
     Q_OBJECT
 
@@ -18,42 +32,246 @@ class QMaterialWidget : public QWidget
     Q_PROPERTY(bool rippleEnabled READ isRippleEnabled WRITE setRippleEnabled)
     Q_PROPERTY(qreal cornerRadius READ cornerRadius WRITE setCornerRadius)
     Q_PROPERTY(QMargins shadowMargins READ shadowMargins WRITE setShadowMargins)
+    Q_PROPERTY(bool autoShadowMargins READ hasAutoShadowMargins WRITE setAutoShadowMargins)
     Q_PROPERTY(qreal shadowIntensity READ shadowIntensity WRITE setShadowIntensity)
+    Q_PROPERTY(ShadowMode shadowMode READ shadowMode WRITE setShadowMode)
+    Q_PROPERTY(ShadowEngine shadowEngine READ shadowEngine WRITE setShadowEngine)
+    Q_PROPERTY(RippleOverflowPolicy rippleOverflowPolicy READ rippleOverflowPolicy WRITE setRippleOverflowPolicy)
+    Q_PROPERTY(RippleRenderer rippleRenderer READ rippleRenderer WRITE setRippleRenderer)
+    Q_PROPERTY(QualityLevel qualityLevel READ qualityLevel NOTIFY qualityLevelChanged)
+    Q_PROPERTY(bool adaptiveQualityEnabled READ isAdaptiveQualityEnabled WRITE setAdaptiveQualityEnabled)
+    Q_PROPERTY(qreal paintBudget READ paintBudget WRITE setPaintBudget)
+    Q_PROPERTY(CornerClipMode cornerClipMode READ cornerClipMode WRITE setCornerClipMode)
+    Q_PROPERTY(bool layerEnabled READ isLayerEnabled WRITE setLayerEnabled)
+    Q_PROPERTY(bool opaqueUpdatesEnabled READ isOpaqueUpdatesEnabled WRITE setOpaqueUpdatesEnabled)
+    Q_PROPERTY(bool animationThrottlingEnabled READ isAnimationThrottlingEnabled WRITE setAnimationThrottlingEnabled)
 
 public:
+    // Способ построения тени из кэша
+    enum ShadowMode {
+        FullShadow,     // отдельное изображение на каждый размер карточки
+        NinePatchShadow // один шаблон на параметры тени, растягивается под размер
+    };
+    Q_ENUM(ShadowMode)
+
+    // Алгоритм растеризации тени
+    enum ShadowEngine {
+        ConcentricShadowEngine, // 8 концентрических полупрозрачных заливок
+        AnalyticShadowEngine    // erf от расстояния до скруглённого прямоугольника, SIMD
+    };
+    Q_ENUM(ShadowEngine)
+
+    // Что делать с нажатием, когда уже идут MaxRipples ripple
+    enum RippleOverflowPolicy {
+        DropOldestRipple,      // самый старый ripple исчезает
+        ReplaceFaintestRipple, // заменяется самый затухший
+        IgnoreNewRipple        // новое нажатие не создаёт ripple
+    };
+    Q_ENUM(RippleOverflowPolicy)
+
+    // Как рисуется круг ripple
+    enum RippleRenderer {
+        EllipseRipple,   // drawEllipse со сглаживанием в каждом кадре
+        SpriteRipple,    // общий кэшированный диск, масштабируется и выводится с прозрачностью
+        SoftSpriteRipple // то же с мягким краем, по той же цене
+    };
+    Q_ENUM(RippleRenderer)
+
+    // Уровень детализации отрисовки
+    enum QualityLevel {
+        FullQuality,    // 8 слоёв тени, сглаживание везде
+        ReducedQuality, // 4 слоя тени, ripple без сглаживания
+        LowQuality      // 2 слоя тени, без сглаживания
+    };
+    Q_ENUM(QualityLevel)
+
+    // Как фон и ripple обрезаются по скруглённым углам карточки
+    enum CornerClipMode {
+        PathClip, // setClipPath по скруглённому прямоугольнику
+        MaskClip  // кэшированная маска углов (DestinationIn), без отсечения по пути
+    };
+    Q_ENUM(CornerClipMode)
+
+    // Число одновременных ripple на карточку (хранятся внутри виджета, без кучи)
+    static constexpr int MaxRipples = 4;
+
     explicit QMaterialWidget(QWidget *parent = nullptr);
+    ~QMaterialWidget() override;
 
     // elevation value used in paint (animated)
     qreal elevation() const { return m_elevation; }
     void setElevation(qreal value);
 
-    bool isElevationEnabled() const { return m_elevationEnabled; }
+    bool isElevationEnabled() const { return m_config->elevationEnabled; }
     void setElevationEnabled(bool on);
 
-    bool isShadowEnabled() const { return m_shadowEnabled; }
+    bool isShadowEnabled() const { return m_config->shadowEnabled; }
     void setShadowEnabled(bool on);
 
-    bool isRippleEnabled() const { return m_rippleEnabled; }
+    bool isRippleEnabled() const { return m_config->rippleEnabled; }
     void setRippleEnabled(bool on);
 
-    qreal cornerRadius() const { return m_cornerRadius; }
+    qreal cornerRadius() const { return m_config->cornerRadius; }
     void setCornerRadius(qreal r);
 
-    QMargins shadowMargins() const { return m_shadowMargins; }
+    // Режим обрезки по скруглению. MaskClip рисует ripple, не задевающие углы,
+    // с прямоугольным отсечением, а остальные — через слой и маску карточки.
+    // Спрайтовые ripple (SpriteRipple, SoftSpriteRipple) обрезаются так же
+    // и в режиме PathClip: иначе отсечение путём съедало бы их выигрыш.
+    CornerClipMode cornerClipMode() const { return m_config->cornerClipMode; }
+    void setCornerClipMode(CornerClipMode mode);
+
+    QMargins shadowMargins() const { return m_config->shadowMargins; }
+    // Явные отступы выключают autoShadowMargins
     void setShadowMargins(const QMargins &margins);
 
-    qreal shadowIntensity() const { return m_shadowIntensity; }
+    // Автоматические отступы под тень: самые узкие, при которых не обрезается
+    // тень наибольшего из уровней setElevationStates. Пересчитываются при смене
+    // уровней и включении тени или elevation. По умолчанию выключено.
+    bool hasAutoShadowMargins() const { return m_config->autoShadowMargins; }
+    void setAutoShadowMargins(bool on);
+
+    qreal shadowIntensity() const { return m_config->shadowIntensity; }
     void setShadowIntensity(qreal intensity);
 
+    ShadowMode shadowMode() const { return m_config->shadowMode; }
+    void setShadowMode(ShadowMode mode);
+
+    ShadowEngine shadowEngine() const { return m_config->shadowEngine; }
+    void setShadowEngine(ShadowEngine engine);
+
     // Настройка уровней elevation
     void setElevationStates(qreal rest, qreal hover, qreal pressed);
+    // То же стандартными уровнями Material: в покое такие карточки делят с
+    // другими одну запись кэша тени, а отступы берутся из готовой таблицы
+    void setElevationStates(QMaterialElevationToken rest, QMaterialElevationToken hover,
+                            QMaterialElevationToken pressed);
 
     // Цвет ripple
-    void setRippleColor(const QColor &c) { m_rippleColor = c; }
+    QColor rippleColor() const { return m_config->rippleColor; }
+    void setRippleColor(const QColor &c);
+
+    RippleOverflowPolicy rippleOverflowPolicy() const { return m_config->rippleOverflowPolicy; }
+    void setRippleOverflowPolicy(RippleOverflowPolicy policy);
+
+    // Спрайты берутся из QMaterialRippleSprites по цвету и корзине размера
+    RippleRenderer rippleRenderer() const { return m_config->rippleRenderer; }
+    void setRippleRenderer(RippleRenderer renderer);
+
+    // Поверхность, которая рисует тень этой карточки (nullptr — тень рисует
+    // сама карточка в своих shadowMargins)
+    QMaterialSurface *shadowSurface() const { return m_surface; }
+
+    // Число ripple, которые сейчас анимируются
+    int activeRippleCount() const { return m_interaction ? m_interaction->ripples.count() : 0; }
+
+    // Заранее растеризует в фоновых потоках тени всех уровней elevation между
+    // состояниями setElevationStates (с шагом кэша) для текущего размера карточки,
+    // чтобы первое наведение не ждало растеризации. Вызывать после раскладки.
+    void prewarmShadows();
+    // То же для всех QMaterialWidget внутри root (включая сам root)
+    static void prewarmShadows(QWidget *root);
+
+    // Адаптивное качество: пока анимация не укладывается в бюджет отрисовки,
+    // уровень детализации понижается; в покое возвращается FullQuality.
+    // По умолчанию выключено.
+    QualityLevel qualityLevel() const { return m_interaction ? m_interaction->quality.level : FullQuality; }
+
+    bool isAdaptiveQualityEnabled() const { return m_config->adaptiveQuality; }
+    void setAdaptiveQualityEnabled(bool on);
+
+    // Бюджет одного paintEvent в миллисекундах (по умолчанию 8 — половина кадра 60 Гц)
+    qreal paintBudget() const { return m_config->paintBudgetMs; }
+    void setPaintBudget(qreal ms);
+
+    // Закрепить уровень: адаптация и возврат к FullQuality не действуют до unpin
+    void pinQualityLevel(QualityLevel level);
+    void unpinQualityLevel();
+    bool isQualityLevelPinned() const { return m_interaction && m_interaction->quality.pinned; }
+
+    // Слой содержимого (аналог layer.enabled в Qt Quick): при старте анимации
+    // дочерние виджеты один раз снимаются в пиксмап, и кадры анимации выводят
+    // его вместо перерисовки детей. Слой сбрасывается в конце анимации или при
+    // изменении детей; с детьми, которые сами заливают фон (autoFillBackground,
+    // WA_OpaquePaintEvent) или имеют собственное окно, не включается.
+    // По умолчанию выключено.
+    bool isLayerEnabled() const { return m_config->layerEnabled; }
+    void setLayerEnabled(bool on);
+    bool isLayerActive() const { return m_interaction && m_interaction->layer; }
+
+    // Если карточка занимает весь виджет (без отступов под тень) и её фон
+    // сплошной, без скруглённых углов, виджет помечается WA_OpaquePaintEvent
+    // и Qt не перерисовывает под ним родителя. По умолчанию включено.
+    bool isOpaqueUpdatesEnabled() const { return m_config->opaqueUpdates; }
+    void setOpaqueUpdatesEnabled(bool on);
+
+    // Пока карточку не видно (скрыта, прокручена за пределы области
+    // прокрутки, окно свёрнуто или перекрыто), анимации не идут: переходы
+    // сразу приходят в конечное состояние, ripple гаснут, и драйвер не держит
+    // карточку. После показа карточка уже в нужном состоянии. По умолчанию включено.
+    bool isAnimationThrottlingEnabled() const { return m_config->animationThrottling; }
+    void setAnimationThrottlingEnabled(bool on);
+
+    // Пакетное изменение настроек: между beginUpdate() и commitUpdate() сеттеры
+    // только запоминают, что устарело, а пересчёт отступов (с раскладкой
+    // родителя) и перерисовка выполняются один раз в commitUpdate().
+    // Вызовы могут вкладываться.
+    void beginUpdate();
+    void commitUpdate();
+    bool isUpdating() const { return m_updateDepth > 0; }
+
+    // То же сразу для всех карточек процесса (например, на время смены темы):
+    // отложенное применяется в commitGlobalUpdate()
+    static void beginGlobalUpdate();
+    static void commitGlobalUpdate();
+    static bool isGlobalUpdating();
+
+    // Отладка перерисовок: поверх каждой перерисованной области рисуется
+    // полупрозрачная заливка, а число пикселей кадра пишется в лог
+    // (категория qmaterialwidget.damage). Также включается переменной
+    // окружения QMATERIALWIDGET_DEBUG_DAMAGE.
+    static bool isDamageDebugEnabled();
+    static void setDamageDebugEnabled(bool on);
+
+    // Статистика отрисовки и анимаций. По умолчанию выключена; включается
+    // setStatisticsEnabled() или переменной окружения QMATERIALWIDGET_STATS=1.
+    struct PhaseStatistics
+    {
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+    };
+
+    struct PaintStatistics
+    {
+        quint64 paintCount = 0;
+        PhaseStatistics paint;      // весь paintEvent
+        PhaseStatistics shadow;
+        PhaseStatistics background;
+        PhaseStatistics ripple;
+        quint64 animationTicks = 0;
+        qreal animationTicksPerSecond = 0.0; // за время активных анимаций
+    };
+
+    static bool isStatisticsEnabled();
+    static void setStatisticsEnabled(bool on);
+
+    PaintStatistics statistics() const;
+    void resetStatistics();
+
+    static PaintStatistics globalStatistics();
+    static void resetGlobalStatistics();
+
+    // Периодическая сводка в лог (категория qmaterialwidget.stats): общая статистика
+    // и самые дорогие карточки. 0 — выключить. По умолчанию берётся из
+    // QMATERIALWIDGET_STATS_INTERVAL (мс), иначе 5000.
+    static int statisticsLogInterval();
+    static void setStatisticsLogInterval(int ms);
+    static void logStatisticsSummary();
 
 signals:
     void elevationChanged(qreal value);
     void clicked(); // удобный сигнал "карточка нажата"
+    void qualityLevelChanged(QualityLevel level);
 
 public:
     // Переопределяем стандартные отступы, чтобы учитывать область тени
@@ -63,7 +281,10 @@ public:
     QMargins contentsMargins() const;
 
 protected:
+    bool event(QEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     void enterEvent(QEnterEvent *event) override;
@@ -74,46 +295,192 @@ protected:
     void leaveEvent(QEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
-
-private slots:
-    void updateRipple();
+    void childEvent(QChildEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 private:
+    friend class QMaterialSurface;
+
+    // Кэш фона и рамки из стиля (QSS), уже обрезанных по скруглению карточки.
+    // Изображения хранятся отдельно для каждого devicePixelRatio, на котором
+    // карточка рисовалась: при переносе окна между экранами 1x и 2x фон не
+    // растеризуется заново и не масштабируется.
+    struct BackgroundAsset
+    {
+        QPixmap pixmap;
+        QImage mask; // форма карточки (только при usesCornerMask)
+        bool opaque = false; // фон непрозрачен внутри карточки
+        bool filled = false; // фон непрозрачен во всём прямоугольнике карточки, включая углы
+    };
+
+    struct BackgroundCache
+    {
+        QSize size;
+        qint64 paletteKey = 0;
+        int state = 0;
+        QString styleSheet;
+        bool valid = false;
+        QHash<int, BackgroundAsset> assets; // по devicePixelRatio * 100
+    };
+
+    bool advanceAnimations(qreal dtMs) override;
+    bool updateRipple(qreal dtMs);
+    QMaterialRippleOverflow rippleOverflow() const;
+    bool updateElevationAnimation(qreal dtMs);
     void startElevationAnimation(qreal target);
+    void stopElevationAnimation();
+    void finishAnimations();
+    bool isPresented() const;
     QRectF effectiveCardRect() const;
+    QMargins effectiveShadowMargins() const;
+    QMargins autoShadowMargins() const;
+    void updateAutoShadowMargins();
+    void applyShadowMargins(const QMargins &margins);
+    void setShadowSurface(QMaterialSurface *surface);
     void applyEffectiveContentsMargins();
     QMargins totalContentsMargins() const;
     QPainterPath cardClipPath(const QRectF &r) const;
+    bool usesCornerMask() const;
+    QMaterialShadowSpec shadowSpec(qreal elevation) const;
     void paintShadow(QPainter &p, const QRectF &cardRect);
     void paintBackground(QPainter &p, const QRectF &cardRect);
+    void paintRipples(QPainter &p, const QRectF &cardRect, qreal dpr, const QImage &mask);
+    void paintDamageDebug(QPainter &p, const QRegion &region);
+
+    // Минимальные области перерисовки
+    QRect shadowRect(qreal elevation) const;
+    QRegion rippleRegion() const;
+    QRegion opaqueInteriorRegion(const QRectF &cardRect) const;
+    int backgroundState() const;
+    bool isBackgroundCacheCurrent(const QSize &size, int state) const;
+    const BackgroundAsset &backgroundAsset(const QRectF &cardRect, qreal dpr);
+    BackgroundAsset renderBackground(const QRectF &cardRect, qreal dpr);
+    void prepareDevicePixelRatio();
+    bool isBackgroundOpaque() const;
+    void invalidateBackground();
+    void updateShadow(qreal previousElevation);
+    void updateRegion(const QRegion &damage);
+    void updateCard();
+    void updateOpaqueHint(const BackgroundAsset &background);
+    void clearOpaqueHint();
+
+    // Что отложено до конца транзакции обновлений
+    enum PendingUpdate : quint8 {
+        PendingRepaint = 0x1,
+        PendingMargins = 0x2,
+        PendingAutoMargins = 0x4,
+        PendingGlobal = 0x8 // карточка записана в глобальную транзакцию
+    };
+    bool deferUpdate(PendingUpdate update);
+    void registerGlobalUpdate();
+    void flushPendingUpdates();
+
+    void captureLayer();
+    void releaseLayer();
+    void dropLayer();
+    void addLayerDamage(const QRegion &damage);
+
+    void setQualityLevel(QualityLevel level);
+    void updateAdaptiveQuality(qint64 paintNs);
+
+    void recordPaint(qint64 shadowNs, qint64 backgroundNs, qint64 rippleNs, qint64 totalNs);
+    void recordAnimationTick(qreal dtMs);
+    PaintStatistics &ensureStatistics();
+
+    // Настройки карточки. Карточки с настройками по умолчанию разделяют один
+    // объект (неявное разделение), копия создаётся при первом изменении.
+    // Чтение — только через config(), чтобы не вызвать лишнего отделения.
+    struct Config : public QSharedData
+    {
+        bool elevationEnabled = true;
+        bool shadowEnabled = true;
+        bool rippleEnabled = true;
+        bool adaptiveQuality = false;
+        bool layerEnabled = false;
+        bool autoShadowMargins = false;
+        bool opaqueUpdates = true;
+        bool animationThrottling = true;
+
+        qreal cornerRadius = 12.0;
+        CornerClipMode cornerClipMode = PathClip;
 
-    // Включатели
-    bool m_elevationEnabled;
-    bool m_shadowEnabled;
-    bool m_rippleEnabled;
+        // Состояния elevation
+        qreal restElevation = 2.0;
+        qreal hoverElevation = 6.0;
+        qreal pressedElevation = 10.0;
+
+        QColor rippleColor = QColor(0, 0, 0, 80);
+        int rippleDurationMs = 250;
+        RippleOverflowPolicy rippleOverflowPolicy = DropOldestRipple;
+        RippleRenderer rippleRenderer = EllipseRipple;
+
+        QMargins shadowMargins = QMargins(24, 24, 24, 36);
+        QMargins userContentsMargins;
+        qreal shadowIntensity = 1.0;
+        ShadowMode shadowMode = FullShadow;
+        ShadowEngine shadowEngine = ConcentricShadowEngine;
+
+        qreal paintBudgetMs = 8.0;
+    };
+
+    static QSharedDataPointer<Config> defaultConfig();
+    const Config &config() const { return *m_config; }
+
+    QSharedDataPointer<Config> m_config;
 
     // Текущий elevation (анимируемое свойство)
     qreal m_elevation;
-    qreal m_cornerRadius;
-
-    // Состояния elevation
-    qreal m_restElevation;
-    qreal m_hoverElevation;
-    qreal m_pressedElevation;
-
-    QPropertyAnimation *m_elevationAnim;
-
-    // Ripple
-    QTimer  m_rippleTimer;
-    QPointF m_rippleCenter;
-    qreal   m_rippleRadius;
-    qreal   m_rippleMaxRadius;
-    qreal   m_rippleOpacity;
-    QColor  m_rippleColor;
-    int     m_rippleDurationMs;
-    bool    m_mousePressedInside;
-
-    QMargins m_shadowMargins;
-    QMargins m_userContentsMargins;
-    qreal m_shadowIntensity;
+
+    // Поверхность, на которой рисуется тень (задаёт сама QMaterialSurface)
+    QMaterialSurface *m_surface;
+
+    // Транзакция обновлений: глубина вложенности и отложенные действия
+    int m_updateDepth;
+    quint8 m_pendingUpdates;
+
+    // Адаптивное качество
+    struct QualityState
+    {
+        QualityLevel level = FullQuality;
+        bool pinned = false;
+        qreal averagePaintMs = 0.0; // скользящее среднее за время анимации
+        int overBudgetFrames = 0;
+    };
+
+    // Снимок дочерних виджетов на время анимации
+    struct LayerState
+    {
+        QPixmap pixmap;
+        QVector<QPointer<QWidget>> widgets; // потомки, чья отрисовка подавляется
+        QRegion invalidated; // что запросила сама карточка (или поверхность под ней) и ещё не нарисовано
+        QRegion frameDamage; // область текущего paintEvent карточки
+        QRegion suppressed;  // где отрисовка детей была подавлена
+    };
+
+    // Состояние взаимодействия: создаётся при первом наведении или нажатии,
+    // карточки, которых не касались, его не держат
+    struct InteractionState
+    {
+        // Переход elevation (продвигается QMaterialAnimationDriver)
+        QMaterialElevationTransition elevationTransition;
+        QMaterialRipplePool<MaxRipples> ripples;
+        QualityState quality;
+        bool mousePressedInside = false;
+        QScopedPointer<LayerState> layer;
+    };
+
+    InteractionState &interaction();
+
+    QScopedPointer<InteractionState> m_interaction;
+
+    // Кэш фона (см. BackgroundCache)
+    QScopedPointer<BackgroundCache> m_background;
+
+    // Статистика создаётся только при включённом сборе
+    struct StatisticsData
+    {
+        PaintStatistics stats;
+        qreal animatedMs = 0.0;
+    };
+    QScopedPointer<StatisticsData> m_statistics;
 };
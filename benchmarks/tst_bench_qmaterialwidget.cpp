@@ -0,0 +1,582 @@
+#include "QMaterialWidget.h"
+#include "QMaterialAnimationDriver.h"
+#include "QMaterialShadowCache.h"
+#include "QMaterialShadowKernel.h"
+
+#include <QApplication>
+#include <QEnterEvent>
+#include <QImage>
+#include <QLabel>
+#include <QPainter>
+#include <QScopeGuard>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QtTest>
+
+#include <cstdlib>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Бенчмарки отрисовки QMaterialWidget.
+// Запуск: bench_qmaterialwidget -o result.xml,xml (или цель run_benchmarks)
+class tst_BenchQMaterialWidget : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // paintEvent по матрице размеров, elevation, радиусов и включателей
+    void paint_data();
+    void paint();
+
+    // Растеризация тени без кэша: концентрический и аналитический движки
+    void shadowRaster_data();
+    void shadowRaster();
+
+    // Проверка: nine-patch тень совпадает с целиком отрисованной
+    void ninePatchMatchesFull_data();
+    void ninePatchMatchesFull();
+
+    // Бэкенды аналитического ядра
+    void shadowKernel_data();
+    void shadowKernel();
+
+    // Последовательности кадров анимаций
+    void rippleAnimation_data();
+    void rippleAnimation();
+    void elevationAnimation_data();
+    void elevationAnimation();
+
+    // Кадры ripple и elevation над карточкой с дочерними виджетами: со слоем и без
+    void layerAnimation_data();
+    void layerAnimation();
+
+    // Первое наведение на карточку нового размера: с холодным и прогретым кэшем
+    void firstHover_data();
+    void firstHover();
+
+    // Создание большого экрана карточек: время, sizeof и байты кучи на экземпляр
+    void construction_data();
+    void construction();
+
+private:
+    static QMaterialWidget *createCard(const QSize &size, qreal cornerRadius);
+    static void sendEnter(QWidget *widget);
+    static void sendLeave(QWidget *widget);
+};
+
+namespace {
+
+// Длительность одного кадра для детерминированного продвижения анимаций
+constexpr qreal FrameMs = 16.0;
+
+// Занятые байты кучи (только glibc), -1 — неизвестно
+qint64 heapBytesInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return qint64(mallinfo2().uordblks);
+#elif defined(__GLIBC__)
+    return qint64(mallinfo().uordblks);
+#else
+    return -1;
+#endif
+}
+
+} // namespace
+
+QMaterialWidget *tst_BenchQMaterialWidget::createCard(const QSize &size, qreal cornerRadius)
+{
+    QMaterialWidget *card = new QMaterialWidget;
+    card->setShadowMargins(QMargins(16, 16, 16, 16));
+    card->setFixedSize(size);
+    card->setCornerRadius(cornerRadius);
+    card->setStyleSheet("background-color: white; border: 1px solid #e0e0e0;");
+    // Карточки рисуются через render() без показа: анимации не должны пропускаться
+    card->setAnimationThrottlingEnabled(false);
+    return card;
+}
+
+void tst_BenchQMaterialWidget::sendEnter(QWidget *widget)
+{
+    const QPointF pos(widget->width() / 2.0, widget->height() / 2.0);
+    QEnterEvent enter(pos, pos, pos);
+    QCoreApplication::sendEvent(widget, &enter);
+}
+
+void tst_BenchQMaterialWidget::sendLeave(QWidget *widget)
+{
+    QEvent leave(QEvent::Leave);
+    QCoreApplication::sendEvent(widget, &leave);
+}
+
+void tst_BenchQMaterialWidget::initTestCase()
+{
+    QMaterialShadowCache::instance()->clear();
+    QMaterialShadowCache::instance()->resetStatistics();
+}
+
+void tst_BenchQMaterialWidget::cleanupTestCase()
+{
+    const QMaterialShadowCache *cache = QMaterialShadowCache::instance();
+    qInfo("shadow cache: %llu hits, %llu misses, %lld bytes",
+          cache->hits(), cache->misses(), cache->usedBytes());
+}
+
+void tst_BenchQMaterialWidget::paint_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<qreal>("elevation");
+    QTest::addColumn<qreal>("cornerRadius");
+    QTest::addColumn<bool>("shadow");
+    QTest::addColumn<bool>("ripple");
+
+    const QList<QSize> sizes = { QSize(160, 100), QSize(332, 182), QSize(832, 432) };
+    const QList<qreal> elevations = { 0.0, 2.0, 10.0 };
+    const QList<qreal> radii = { 0.0, 12.0 };
+
+    for (const QSize &size : sizes) {
+        for (qreal elevation : elevations) {
+            for (qreal radius : radii) {
+                for (int flags = 0; flags < 4; ++flags) {
+                    const bool shadow = flags & 1;
+                    const bool ripple = flags & 2;
+                    const QByteArray name = QByteArray::number(size.width()) + 'x'
+                        + QByteArray::number(size.height())
+                        + " e" + QByteArray::number(elevation)
+                        + " r" + QByteArray::number(radius)
+                        + (shadow ? " shadow" : " noshadow")
+                        + (ripple ? " ripple" : " noripple");
+                    QTest::newRow(name.constData()) << size << elevation << radius << shadow << ripple;
+                }
+            }
+        }
+    }
+}
+
+void tst_BenchQMaterialWidget::paint()
+{
+    QFETCH(QSize, size);
+    QFETCH(qreal, elevation);
+    QFETCH(qreal, cornerRadius);
+    QFETCH(bool, shadow);
+    QFETCH(bool, ripple);
+
+    QScopedPointer<QMaterialWidget> card(createCard(size, cornerRadius));
+    card->setShadowEnabled(shadow);
+    card->setRippleEnabled(ripple);
+    card->setElevation(elevation);
+
+    if (ripple) {
+        // Ripple в середине своего пути
+        QTest::mousePress(card.data(), Qt::LeftButton, Qt::NoModifier, card->rect().center());
+        QMaterialAnimationDriver::instance()->advance(5 * FrameMs);
+        card->setElevation(elevation);
+    }
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QBENCHMARK {
+        card->render(&image);
+    }
+}
+
+void tst_BenchQMaterialWidget::shadowRaster_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<qreal>("elevation");
+    QTest::addColumn<bool>("analytic");
+
+    const QList<QSize> sizes = { QSize(128, 68), QSize(300, 150), QSize(800, 400) };
+    const QList<qreal> elevations = { 2.0, 10.0, 24.0 };
+
+    for (const QSize &size : sizes) {
+        for (qreal elevation : elevations) {
+            for (int analytic = 0; analytic < 2; ++analytic) {
+                const QByteArray name = QByteArray::number(size.width()) + 'x'
+                    + QByteArray::number(size.height())
+                    + " e" + QByteArray::number(elevation)
+                    + (analytic ? " analytic" : " concentric");
+                QTest::newRow(name.constData()) << size << elevation << bool(analytic);
+            }
+        }
+    }
+}
+
+void tst_BenchQMaterialWidget::shadowRaster()
+{
+    QFETCH(QSize, size);
+    QFETCH(qreal, elevation);
+    QFETCH(bool, analytic);
+
+    QMaterialShadowSpec spec;
+    spec.elevation = elevation;
+    spec.engine = analytic ? QMaterialShadowEngine::Analytic : QMaterialShadowEngine::Concentric;
+
+    const QMaterialShadowKey key = QMaterialShadowCache::makeKey(size, spec, 1.0);
+
+    QBENCHMARK {
+        const QImage image = QMaterialShadowCache::renderShadow(key);
+        Q_UNUSED(image);
+    }
+}
+
+void tst_BenchQMaterialWidget::ninePatchMatchesFull_data()
+{
+    QTest::addColumn<qreal>("cornerRadius");
+    QTest::addColumn<qreal>("elevation");
+    QTest::addColumn<bool>("analytic");
+
+    // Малый радиус при большом elevation — худший случай для разбиения углов
+    const QList<QPair<qreal, qreal>> pairs = { { 4.0, 2.0 }, { 4.0, 8.0 }, { 4.0, 24.0 },
+                                               { 12.0, 6.0 }, { 12.0, 24.0 }, { 2.0, 16.0 } };
+    for (const QPair<qreal, qreal> &pair : pairs) {
+        for (int analytic = 0; analytic < 2; ++analytic) {
+            const QByteArray name = "r" + QByteArray::number(pair.first)
+                + " e" + QByteArray::number(pair.second)
+                + (analytic ? " analytic" : " concentric");
+            QTest::newRow(name.constData()) << pair.first << pair.second << bool(analytic);
+        }
+    }
+}
+
+void tst_BenchQMaterialWidget::ninePatchMatchesFull()
+{
+    QFETCH(qreal, cornerRadius);
+    QFETCH(qreal, elevation);
+    QFETCH(bool, analytic);
+
+    QMaterialShadowSpec spec;
+    spec.cornerRadius = cornerRadius;
+    spec.elevation = elevation;
+    spec.engine = analytic ? QMaterialShadowEngine::Analytic : QMaterialShadowEngine::Concentric;
+
+    const QSize cardSize(240, 140);
+    const QMaterialShadowKey key = QMaterialShadowCache::makeKey(cardSize, spec, 1.0);
+    const QMargins pad = QMaterialShadowCache::shadowPadding(key.spec());
+    const QImage full = QMaterialShadowCache::renderShadow(key)
+                            .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    QImage patched(full.size(), QImage::Format_ARGB32_Premultiplied);
+    patched.fill(Qt::transparent);
+    {
+        QPainter p(&patched);
+        QMaterialShadowCache::instance()->paintNinePatchShadow(
+            p, QRectF(QPointF(pad.left(), pad.top()), QSizeF(cardSize)), spec);
+    }
+
+    // Допуск на округление при растяжении частей шаблона
+    constexpr int Tolerance = 2;
+    int maxDiff = 0;
+    QPoint worst;
+    for (int y = 0; y < full.height(); ++y) {
+        const QRgb *a = reinterpret_cast<const QRgb *>(full.constScanLine(y));
+        const QRgb *b = reinterpret_cast<const QRgb *>(patched.constScanLine(y));
+        for (int x = 0; x < full.width(); ++x) {
+            const int diff = qAbs(qAlpha(a[x]) - qAlpha(b[x]));
+            if (diff > maxDiff) {
+                maxDiff = diff;
+                worst = QPoint(x, y);
+            }
+        }
+    }
+
+    QVERIFY2(maxDiff <= Tolerance,
+             qPrintable(QStringLiteral("alpha differs by %1 at (%2, %3)")
+                            .arg(maxDiff).arg(worst.x()).arg(worst.y())));
+}
+
+void tst_BenchQMaterialWidget::shadowKernel_data()
+{
+    QTest::addColumn<int>("backend");
+
+    for (int backend = QMaterialShadowKernel::ScalarBackend;
+         backend <= QMaterialShadowKernel::bestBackend(); ++backend) {
+        QTest::newRow(QMaterialShadowKernel::backendName(QMaterialShadowKernel::Backend(backend))) << backend;
+    }
+}
+
+void tst_BenchQMaterialWidget::shadowKernel()
+{
+    QFETCH(int, backend);
+
+    QImage image(QSize(400, 240), QImage::Format_ARGB32_Premultiplied);
+
+    QMaterialShadowKernelParams params;
+    params.centerX = 200.0f;
+    params.centerY = 124.0f;
+    params.halfWidth = 160.0f;
+    params.halfHeight = 90.0f;
+    params.radius = 12.0f;
+    params.sigma = 4.25f;
+    params.shift = 6.8f;
+    params.peak = 0.5f;
+
+    QBENCHMARK {
+        QMaterialShadowKernel::render(image, params, QMaterialShadowKernel::Backend(backend));
+    }
+}
+
+void tst_BenchQMaterialWidget::rippleAnimation_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("taps");
+    QTest::addColumn<int>("clip");
+    QTest::addColumn<int>("renderer");
+
+    const int path = QMaterialWidget::PathClip;
+    const int mask = QMaterialWidget::MaskClip;
+    const int ellipse = QMaterialWidget::EllipseRipple;
+    const int sprite = QMaterialWidget::SpriteRipple;
+    const int soft = QMaterialWidget::SoftSpriteRipple;
+
+    QTest::newRow("332x182") << QSize(332, 182) << 1 << path << ellipse;
+    QTest::newRow("832x432") << QSize(832, 432) << 1 << path << ellipse;
+    // Быстрые повторные нажатия: несколько ripple одновременно, пул переполняется
+    QTest::newRow("332x182 6 taps") << QSize(332, 182) << 6 << path << ellipse;
+    QTest::newRow("832x432 6 taps") << QSize(832, 432) << 6 << path << ellipse;
+
+    // Обрезка по маске углов вместо setClipPath
+    QTest::newRow("332x182 mask") << QSize(332, 182) << 1 << mask << ellipse;
+    QTest::newRow("832x432 mask") << QSize(832, 432) << 1 << mask << ellipse;
+    QTest::newRow("332x182 6 taps mask") << QSize(332, 182) << 6 << mask << ellipse;
+    QTest::newRow("832x432 6 taps mask") << QSize(832, 432) << 6 << mask << ellipse;
+
+    // Спрайт вместо drawEllipse: жёсткий и мягкий край
+    QTest::newRow("332x182 sprite") << QSize(332, 182) << 1 << path << sprite;
+    QTest::newRow("832x432 sprite") << QSize(832, 432) << 1 << path << sprite;
+    QTest::newRow("832x432 6 taps sprite") << QSize(832, 432) << 6 << path << sprite;
+    QTest::newRow("832x432 6 taps mask sprite") << QSize(832, 432) << 6 << mask << sprite;
+    QTest::newRow("832x432 6 taps soft") << QSize(832, 432) << 6 << path << soft;
+}
+
+void tst_BenchQMaterialWidget::rippleAnimation()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, taps);
+    QFETCH(int, clip);
+    QFETCH(int, renderer);
+
+    QScopedPointer<QMaterialWidget> card(createCard(size, 12.0));
+    card->setCornerClipMode(QMaterialWidget::CornerClipMode(clip));
+    card->setRippleRenderer(QMaterialWidget::RippleRenderer(renderer));
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    // Полный цикл ripple: нажатия каждые два кадра и кадры до полного затухания
+    QBENCHMARK {
+        for (int frame = 0; frame < 20 + 2 * taps; ++frame) {
+            if (frame % 2 == 0 && frame / 2 < taps) {
+                const QPoint pos(size.width() * (frame / 2 + 1) / (taps + 1), size.height() / 2);
+                QTest::mousePress(card.data(), Qt::LeftButton, Qt::NoModifier, pos);
+                QTest::mouseRelease(card.data(), Qt::LeftButton, Qt::NoModifier, pos);
+            }
+            QMaterialAnimationDriver::instance()->advance(FrameMs);
+            card->render(&image);
+        }
+    }
+}
+
+void tst_BenchQMaterialWidget::elevationAnimation_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("quality");
+    QTest::addColumn<bool>("cache");
+
+    QTest::newRow("332x182") << QSize(332, 182) << int(QMaterialWidget::FullQuality) << true;
+    QTest::newRow("832x432") << QSize(832, 432) << int(QMaterialWidget::FullQuality) << true;
+
+    // Уровни качества без кэша: тень растеризуется в каждом кадре
+    QTest::newRow("832x432 full nocache") << QSize(832, 432) << int(QMaterialWidget::FullQuality) << false;
+    QTest::newRow("832x432 reduced nocache") << QSize(832, 432) << int(QMaterialWidget::ReducedQuality) << false;
+    QTest::newRow("832x432 low nocache") << QSize(832, 432) << int(QMaterialWidget::LowQuality) << false;
+}
+
+void tst_BenchQMaterialWidget::elevationAnimation()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, quality);
+    QFETCH(bool, cache);
+
+    QScopedPointer<QMaterialWidget> card(createCard(size, 12.0));
+    card->pinQualityLevel(QMaterialWidget::QualityLevel(quality));
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QMaterialShadowCache::instance()->setEnabled(cache);
+    auto restoreCache = qScopeGuard([] { QMaterialShadowCache::instance()->setEnabled(true); });
+
+    // Наведение и уход курсора: два перехода elevation по 150 мс
+    QBENCHMARK {
+        sendEnter(card.data());
+        for (int frame = 0; frame < 10; ++frame) {
+            QMaterialAnimationDriver::instance()->advance(FrameMs);
+            card->render(&image);
+        }
+        sendLeave(card.data());
+        for (int frame = 0; frame < 10; ++frame) {
+            QMaterialAnimationDriver::instance()->advance(FrameMs);
+            card->render(&image);
+        }
+    }
+}
+
+void tst_BenchQMaterialWidget::layerAnimation_data()
+{
+    QTest::addColumn<int>("children");
+    QTest::addColumn<bool>("layer");
+
+    QTest::newRow("4 children") << 4 << false;
+    QTest::newRow("4 children layer") << 4 << true;
+    QTest::newRow("16 children") << 16 << false;
+    QTest::newRow("16 children layer") << 16 << true;
+}
+
+void tst_BenchQMaterialWidget::layerAnimation()
+{
+    QFETCH(int, children);
+    QFETCH(bool, layer);
+
+    const QSize size(432, 100 + children * 24);
+    QScopedPointer<QMaterialWidget> card(createCard(size, 12.0));
+    card->setLayerEnabled(layer);
+
+    QVBoxLayout *layout = new QVBoxLayout(card.data());
+    for (int i = 0; i < children; ++i) {
+        if (i % 4 == 3) {
+            layout->addWidget(new QPushButton(QStringLiteral("Button %1").arg(i), card.data()));
+        } else {
+            layout->addWidget(new QLabel(QStringLiteral("Label %1 with some text").arg(i), card.data()));
+        }
+    }
+
+    // Слой снимается только с видимой карточки
+    card->show();
+    QVERIFY(QTest::qWaitForWindowExposed(card.data()));
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    const QPoint center(size.width() / 2, size.height() / 2);
+
+    // Наведение, нажатие с ripple и уход курсора
+    QBENCHMARK {
+        sendEnter(card.data());
+        QTest::mousePress(card.data(), Qt::LeftButton, Qt::NoModifier, center);
+        QTest::mouseRelease(card.data(), Qt::LeftButton, Qt::NoModifier, center);
+        for (int frame = 0; frame < 20; ++frame) {
+            QMaterialAnimationDriver::instance()->advance(FrameMs);
+            card->render(&image);
+        }
+        sendLeave(card.data());
+        for (int frame = 0; frame < 10; ++frame) {
+            QMaterialAnimationDriver::instance()->advance(FrameMs);
+            card->render(&image);
+        }
+    }
+}
+
+void tst_BenchQMaterialWidget::firstHover_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("prewarm");
+
+    QTest::newRow("832x432 cold") << QSize(832, 432) << false;
+    QTest::newRow("832x432 prewarmed") << QSize(832, 432) << true;
+}
+
+void tst_BenchQMaterialWidget::firstHover()
+{
+    QFETCH(QSize, size);
+    QFETCH(bool, prewarm);
+
+    QScopedPointer<QMaterialWidget> card(createCard(size, 12.0));
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QMaterialShadowCache *cache = QMaterialShadowCache::instance();
+    cache->clear();
+    card->render(&image);
+
+    if (prewarm) {
+        // Фоновая растеризация и доставка готовых изображений в GUI-поток
+        card->prewarmShadows();
+        cache->waitForPrewarm();
+        QCoreApplication::processEvents();
+        QCOMPARE(cache->pendingCount(), 0);
+    }
+
+    // Один раз: повторные итерации шли бы уже по прогретому кэшу
+    QBENCHMARK_ONCE {
+        sendEnter(card.data());
+        for (int frame = 0; frame < 10; ++frame) {
+            QMaterialAnimationDriver::instance()->advance(FrameMs);
+            card->render(&image);
+        }
+    }
+}
+
+void tst_BenchQMaterialWidget::construction_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("1000 cards") << 1000;
+    QTest::newRow("10000 cards") << 10000;
+}
+
+void tst_BenchQMaterialWidget::construction()
+{
+    QFETCH(int, count);
+
+    // Опорная точка: столько же голых QWidget у такого же родителя
+    QScopedPointer<QWidget> baselineScreen(new QWidget);
+    const qint64 baselineBefore = heapBytesInUse();
+    for (int i = 0; i < count; ++i)
+        new QWidget(baselineScreen.data());
+    const qint64 perWidget = baselineBefore >= 0 ? (heapBytesInUse() - baselineBefore) / count : -1;
+
+    // Карточки — дети одного окна, как на реальном экране
+    QScopedPointer<QWidget> screen(new QWidget);
+    const qint64 heapBefore = heapBytesInUse();
+
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < count; ++i)
+            new QMaterialWidget(screen.data());
+    }
+
+    const qint64 heapAfter = heapBytesInUse();
+    const qint64 perCard = heapBefore >= 0 ? (heapAfter - heapBefore) / count : -1;
+    qInfo("sizeof(QMaterialWidget) = %d bytes, heap per card = %lld bytes (QWidget: %d and %lld)",
+          int(sizeof(QMaterialWidget)), perCard, int(sizeof(QWidget)), perWidget);
+
+    // Свои поля карточки — указатель на общие настройки, elevation и
+    // несколько указателей на ленивое состояние. Новое поле по значению
+    // (пиксмап, контейнер, состояние анимации) выходит за этот предел.
+    const int ownBytes = int(sizeof(QMaterialWidget) - sizeof(QWidget));
+    QVERIFY2(ownBytes <= 10 * int(sizeof(void *)),
+             qPrintable(QStringLiteral("QMaterialWidget adds %1 bytes to QWidget").arg(ownBytes)));
+
+    // Сверх голого QWidget карточка не должна ничего выделять в куче при
+    // создании: настройки общие, состояние создаётся при первом взаимодействии.
+    // Запас покрывает сами поля карточки и округление аллокатора.
+    if (perCard >= 0) {
+        const qint64 extraHeap = perCard - perWidget;
+        QVERIFY2(extraHeap <= ownBytes + 64,
+                 qPrintable(QStringLiteral("a card allocates %1 bytes more than a QWidget").arg(extraHeap)));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Без дисплея: offscreen, если платформа не задана явно
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    tst_BenchQMaterialWidget tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "tst_bench_qmaterialwidget.moc"
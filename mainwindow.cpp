@@ -1,12 +1,12 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
 #include "QMaterialWidget.h"
+#include "QMaterialSurface.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QPushButton>
 #include <QSpacerItem>
-#include <QMargins>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -16,31 +16,15 @@ MainWindow::MainWindow(QWidget *parent)
     setWindowTitle("Пример использования QMaterialWidget");
     resize(900, 700);
 
-    // Создаём центральный виджет с вертикальным layout
-    QWidget *centralWidget = new QWidget(this);
+    // Центральный виджет — поверхность, которая рисует тени всех карточек
+    // за один проход, поэтому карточкам не нужны прозрачные поля под тень
+    QMaterialSurface *centralWidget = new QMaterialSurface(this);
     setCentralWidget(centralWidget);
     
     QVBoxLayout *mainLayout = new QVBoxLayout(centralWidget);
     mainLayout->setSpacing(30);
     mainLayout->setContentsMargins(40, 40, 40, 40);
 
-    const auto configureShadowMargins = [](QMaterialWidget *card) {
-        card->setShadowMargins(QMargins(16, 16, 16, 16));
-    };
-
-    const auto wrapCardWithMargin = [](QWidget *card, int margin = 0) {
-        QWidget *wrapper = new QWidget;
-        wrapper->setAttribute(Qt::WA_NoSystemBackground, true);
-        wrapper->setAttribute(Qt::WA_TranslucentBackground, true);
-
-        QVBoxLayout *wrapperLayout = new QVBoxLayout(wrapper);
-        wrapperLayout->setContentsMargins(margin, margin, margin, margin);
-        wrapperLayout->setSpacing(0);
-        wrapperLayout->addWidget(card, 0, Qt::AlignCenter);
-
-        return wrapper;
-    };
-
     // Заголовок
     QLabel *titleLabel = new QLabel("Примеры Material Design виджетов", this);
     titleLabel->setStyleSheet("font-size: 24px; font-weight: bold; color: #333;");
@@ -48,8 +32,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Пример 1: Базовая карточка
     QMaterialWidget *card1 = new QMaterialWidget(this);
-    configureShadowMargins(card1);
-    card1->setFixedSize(300, 150);
+    card1->setFixedSize(268, 118);
     card1->setStyleSheet("background-color: white; border: 1px solid #e0e0e0;");
     
     QVBoxLayout *card1Layout = new QVBoxLayout(card1);
@@ -71,8 +54,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Пример 2: Карточка с настройками elevation
     QMaterialWidget *card2 = new QMaterialWidget(this);
-    configureShadowMargins(card2);
-    card2->setFixedSize(300, 150);
+    card2->setFixedSize(268, 118);
     card2->setStyleSheet("background-color: #2196F3; border: none;");
     card2->setElevationStates(4.0, 5.0, 6.0); // rest, hover, pressed
     card2->setCornerRadius(16.0);
@@ -91,8 +73,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Пример 3: Карточка без ripple эффекта
     QMaterialWidget *card3 = new QMaterialWidget(this);
-    configureShadowMargins(card3);
-    card3->setFixedSize(300, 150);
+    card3->setFixedSize(268, 118);
     card3->setStyleSheet("background-color: #4CAF50; border: none;");
     card3->setRippleEnabled(false);
     card3->setCornerRadius(8.0);
@@ -111,8 +92,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Пример 4: Карточка с кастомным цветом ripple
     QMaterialWidget *card4 = new QMaterialWidget(this);
-    configureShadowMargins(card4);
-    card4->setFixedSize(300, 150);
+    card4->setFixedSize(268, 118);
     card4->setStyleSheet("background-color: #FF9800; border: none;");
     card4->setRippleColor(QColor(255, 255, 255, 120)); // Белый ripple
     card4->setCornerRadius(20.0);
@@ -133,15 +113,15 @@ MainWindow::MainWindow(QWidget *parent)
     QHBoxLayout *cardsLayout = new QHBoxLayout();
     cardsLayout->setSpacing(20);
     cardsLayout->setContentsMargins(0, 0, 0, 0);
-    cardsLayout->addWidget(wrapCardWithMargin(card1));
-    cardsLayout->addWidget(wrapCardWithMargin(card2));
+    cardsLayout->addWidget(card1);
+    cardsLayout->addWidget(card2);
     cardsLayout->addStretch();
     
     QHBoxLayout *cardsLayout2 = new QHBoxLayout();
     cardsLayout2->setSpacing(20);
     cardsLayout2->setContentsMargins(20, 20, 20, 20);
-    cardsLayout2->addWidget(wrapCardWithMargin(card3));
-    cardsLayout2->addWidget(wrapCardWithMargin(card4));
+    cardsLayout2->addWidget(card3);
+    cardsLayout2->addWidget(card4);
     cardsLayout2->addStretch();
 
     mainLayout->addLayout(cardsLayout);
@@ -150,8 +130,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Пример 5: Карточка с кнопкой внутри
     QMaterialWidget *card5 = new QMaterialWidget(this);
-    configureShadowMargins(card5);
-    card5->setFixedSize(400, 200);
+    card5->setFixedSize(368, 168);
     card5->setStyleSheet("background-color: white; border: 1px solid #e0e0e0;");
     
     QVBoxLayout *card5Layout = new QVBoxLayout(card5);
@@ -187,7 +166,7 @@ MainWindow::MainWindow(QWidget *parent)
         setWindowTitle("Карточка с кнопкой была нажата!");
     });
 
-    mainLayout->addWidget(wrapCardWithMargin(card5, 16), 0, Qt::AlignHCenter);
+    mainLayout->addWidget(card5, 0, Qt::AlignHCenter);
     mainLayout->addStretch(); 
 
     // Устанавливаем фон окна
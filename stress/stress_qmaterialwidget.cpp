@@ -0,0 +1,504 @@
+#include "QMaterialWidget.h"
+#include "QMaterialAnimationDriver.h"
+#include "QMaterialSurface.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEnterEvent>
+#include <QFile>
+#include <QGridLayout>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLabel>
+#include <QMouseEvent>
+#include <QPointer>
+#include <QScrollArea>
+#include <QScrollBar>
+#include <QTextStream>
+#include <QVBoxLayout>
+#include <QWindow>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+// Стресс-тест QMaterialWidget: сотни и десятки тысяч карточек в QScrollArea,
+// синтетические последовательности наведения, нажатий, прокрутки и изменения
+// размера окна. Отчёт (FPS, перцентили времени кадра, RSS, время создания)
+// печатается в формате JSON. Работает без дисплея:
+//   stress_qmaterialwidget -platform offscreen --cards 10000 --output report.json
+// С порогами --min-fps, --max-p99 и --max-rss код возврата равен 1, если они
+// не выполнены, поэтому тест можно использовать как проверку перед релизом.
+
+namespace {
+
+// Шаг анимаций на кадр: драйвер продвигается вручную, а не по таймеру
+constexpr qreal FrameMs = 16.0;
+
+struct Options
+{
+    int cards = 1000;
+    int columns = 4;
+    int frames = 120;
+    QSize cardSize = QSize(280, 120);
+    QSize windowSize = QSize(1280, 800);
+    bool surface = false;
+    bool layer = false;
+    bool autoMargins = false;
+    QMaterialWidget::ShadowMode shadowMode = QMaterialWidget::FullShadow;
+    QMaterialWidget::ShadowEngine shadowEngine = QMaterialWidget::ConcentricShadowEngine;
+    QString output;
+    double minFps = 0.0;
+    double maxP99Ms = 0.0;
+    double maxRssMb = 0.0;
+};
+
+QSize parseSize(const QString &text, const QSize &fallback)
+{
+    const QStringList parts = text.split(QLatin1Char('x'));
+    if (parts.size() != 2)
+        return fallback;
+
+    bool okWidth = false;
+    bool okHeight = false;
+    const QSize size(parts.at(0).toInt(&okWidth), parts.at(1).toInt(&okHeight));
+    return okWidth && okHeight && size.isValid() ? size : fallback;
+}
+
+// Поле /proc/self/status в килобайтах (только Linux), -1 — неизвестно
+qint64 procStatusKb(const QByteArray &field)
+{
+    QFile file(QStringLiteral("/proc/self/status"));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return -1;
+
+    const QByteArray prefix = field + ':';
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (line.startsWith(prefix))
+            return line.mid(prefix.size()).trimmed().split(' ').value(0).toLongLong();
+    }
+    return -1;
+}
+
+double megabytes(qint64 kb)
+{
+    return kb < 0 ? -1.0 : kb / 1024.0;
+}
+
+// Перцентиль по ближайшему рангу из отсортированных значений
+double percentile(const QVector<double> &sorted, double p)
+{
+    if (sorted.isEmpty())
+        return 0.0;
+
+    const int rank = qBound(0, int(std::ceil(p * sorted.size())) - 1, int(sorted.size()) - 1);
+    return sorted.at(rank);
+}
+
+struct PhaseResult
+{
+    QString name;
+    QVector<double> frameMs;
+};
+
+QJsonObject summarize(const QVector<double> &frameMs)
+{
+    QVector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for (double ms : sorted)
+        total += ms;
+
+    QJsonObject result;
+    result.insert(QStringLiteral("frames"), int(sorted.size()));
+    result.insert(QStringLiteral("fps"), total > 0.0 ? sorted.size() * 1000.0 / total : 0.0);
+    result.insert(QStringLiteral("mean_ms"), sorted.isEmpty() ? 0.0 : total / sorted.size());
+    result.insert(QStringLiteral("p50_ms"), percentile(sorted, 0.50));
+    result.insert(QStringLiteral("p90_ms"), percentile(sorted, 0.90));
+    result.insert(QStringLiteral("p99_ms"), percentile(sorted, 0.99));
+    result.insert(QStringLiteral("max_ms"), sorted.isEmpty() ? 0.0 : sorted.last());
+    return result;
+}
+
+class StressRun
+{
+public:
+    explicit StressRun(const Options &options)
+        : m_options(options)
+    {
+    }
+
+    // Возвращает время создания карточек и раскладки в миллисекундах
+    double build();
+    // Показывает окно и ждёт первого кадра
+    double showAndWaitForFirstFrame();
+
+    PhaseResult runHover();
+    PhaseResult runPress();
+    PhaseResult runScroll();
+    PhaseResult runResize();
+
+private:
+    double frame(const std::function<void()> &action);
+    QMaterialWidget *cardAt(const QPoint &viewportPos) const;
+    QPoint sweepPoint(int step) const;
+
+    const Options m_options;
+    QScrollArea m_window;
+    QPointer<QMaterialWidget> m_hovered;
+};
+
+double StressRun::build()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QWidget *container = m_options.surface ? new QMaterialSurface : new QWidget;
+    container->setObjectName(QStringLiteral("stressContainer"));
+    // Один styleSheet на контейнер, а не на каждую карточку
+    container->setStyleSheet(QStringLiteral(
+        "#stressContainer { background-color: #f5f5f5; }"
+        "QMaterialWidget { background-color: white; border: 1px solid #e0e0e0; }"
+        "QLabel { color: #212121; }"));
+
+    QGridLayout *layout = new QGridLayout(container);
+    layout->setContentsMargins(24, 24, 24, 36);
+    layout->setSpacing(m_options.surface ? 24 : 0);
+
+    for (int i = 0; i < m_options.cards; ++i) {
+        QMaterialWidget *card = new QMaterialWidget(container);
+        card->setFixedSize(m_options.cardSize);
+        card->setShadowMode(m_options.shadowMode);
+        card->setShadowEngine(m_options.shadowEngine);
+        card->setLayerEnabled(m_options.layer);
+        if (m_options.autoMargins)
+            card->setAutoShadowMargins(true);
+
+        QVBoxLayout *cardLayout = new QVBoxLayout(card);
+        cardLayout->addWidget(new QLabel(QStringLiteral("Card %1").arg(i), card));
+        cardLayout->addWidget(new QLabel(QStringLiteral("Synthetic stress content"), card));
+        cardLayout->addStretch();
+
+        layout->addWidget(card, i / m_options.columns, i % m_options.columns);
+    }
+
+    m_window.setWidgetResizable(true);
+    m_window.setWidget(container);
+    m_window.resize(m_options.windowSize);
+    container->layout()->activate();
+
+    return timer.nsecsElapsed() / 1e6;
+}
+
+double StressRun::showAndWaitForFirstFrame()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    m_window.show();
+    QWindow *window = m_window.windowHandle();
+    while (!window || !window->isExposed()) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        window = m_window.windowHandle();
+        if (timer.elapsed() > 10000)
+            break;
+    }
+    m_window.repaint();
+    QCoreApplication::processEvents();
+
+    return timer.nsecsElapsed() / 1e6;
+}
+
+double StressRun::frame(const std::function<void()> &action)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Ввод, шаг анимаций и перерисовка накопленных областей, как в одном кадре
+    action();
+    QMaterialAnimationDriver::instance()->advance(FrameMs);
+    QCoreApplication::processEvents();
+
+    // В Qt 6 backing store синхронизируется по таймеру UpdateRequest, и
+    // processEvents мог вернуться до отрисовки. Синхронизация здесь же
+    // перерисовывает накопленные области и выводит их, так что кадр
+    // измеряется вместе с отрисовкой (в Qt 5 она обычно уже прошла).
+    QEvent updateRequest(QEvent::UpdateRequest);
+    QCoreApplication::sendEvent(&m_window, &updateRequest);
+
+    return timer.nsecsElapsed() / 1e6;
+}
+
+QMaterialWidget *StressRun::cardAt(const QPoint &viewportPos) const
+{
+    QWidget *container = m_window.widget();
+    QWidget *child = container->childAt(container->mapFrom(m_window.viewport(), viewportPos));
+
+    // childAt возвращает самого глубокого потомка (например, QLabel в карточке)
+    while (child && child != container) {
+        if (QMaterialWidget *card = qobject_cast<QMaterialWidget *>(child))
+            return card;
+        child = child->parentWidget();
+    }
+    return nullptr;
+}
+
+QPoint StressRun::sweepPoint(int step) const
+{
+    // Курсор проходит viewport змейкой с шагом в полкарточки
+    const QSize viewport = m_window.viewport()->size();
+    const int stepX = qMax(1, m_options.cardSize.width() / 2);
+    const int stepY = qMax(1, m_options.cardSize.height() / 2);
+    const int perRow = qMax(1, viewport.width() / stepX);
+    const int rows = qMax(1, viewport.height() / stepY);
+
+    const int row = (step / perRow) % rows;
+    const int column = step % perRow;
+    return QPoint(column * stepX + stepX / 2, row * stepY + stepY / 2);
+}
+
+void sendEnter(QWidget *widget, const QPoint &pos)
+{
+    QEnterEvent enter(pos, pos, widget->mapToGlobal(pos));
+    QCoreApplication::sendEvent(widget, &enter);
+}
+
+void sendLeave(QWidget *widget)
+{
+    QEvent leave(QEvent::Leave);
+    QCoreApplication::sendEvent(widget, &leave);
+}
+
+void sendMouse(QWidget *widget, QEvent::Type type, const QPoint &pos)
+{
+    const Qt::MouseButtons buttons = type == QEvent::MouseButtonPress ? Qt::LeftButton : Qt::NoButton;
+    QMouseEvent event(type, QPointF(pos), QPointF(widget->mapToGlobal(pos)),
+                      Qt::LeftButton, buttons, Qt::NoModifier);
+    QCoreApplication::sendEvent(widget, &event);
+}
+
+PhaseResult StressRun::runHover()
+{
+    PhaseResult result{QStringLiteral("hover"), {}};
+
+    for (int i = 0; i < m_options.frames; ++i) {
+        result.frameMs.append(frame([this, i] {
+            const QPoint pos = sweepPoint(i);
+            QMaterialWidget *card = cardAt(pos);
+            if (card == m_hovered)
+                return;
+
+            if (m_hovered)
+                sendLeave(m_hovered);
+            m_hovered = card;
+            if (card)
+                sendEnter(card, card->mapFrom(m_window.viewport(), pos));
+        }));
+    }
+
+    if (m_hovered)
+        sendLeave(m_hovered);
+    m_hovered = nullptr;
+    return result;
+}
+
+PhaseResult StressRun::runPress()
+{
+    PhaseResult result{QStringLiteral("press"), {}};
+
+    // Нажатие и отпускание каждые два кадра: ripple перекрываются
+    for (int i = 0; i < m_options.frames; ++i) {
+        result.frameMs.append(frame([this, i] {
+            const QPoint pos = sweepPoint(i / 2);
+            QMaterialWidget *card = cardAt(pos);
+            if (!card)
+                return;
+
+            const QPoint local = card->mapFrom(m_window.viewport(), pos);
+            sendMouse(card, i % 2 == 0 ? QEvent::MouseButtonPress : QEvent::MouseButtonRelease, local);
+        }));
+    }
+    return result;
+}
+
+PhaseResult StressRun::runScroll()
+{
+    PhaseResult result{QStringLiteral("scroll"), {}};
+
+    QScrollBar *bar = m_window.verticalScrollBar();
+    const int step = qMax(1, m_window.viewport()->height() / 10);
+    int direction = 1;
+
+    for (int i = 0; i < m_options.frames; ++i) {
+        result.frameMs.append(frame([bar, step, &direction] {
+            if (bar->value() + direction * step > bar->maximum() || bar->value() + direction * step < bar->minimum())
+                direction = -direction;
+            bar->setValue(bar->value() + direction * step);
+        }));
+    }
+
+    bar->setValue(bar->minimum());
+    return result;
+}
+
+PhaseResult StressRun::runResize()
+{
+    PhaseResult result{QStringLiteral("resize"), {}};
+
+    // Ширина окна колеблется между 60% и 100% исходной
+    const QSize base = m_options.windowSize;
+    for (int i = 0; i < m_options.frames; ++i) {
+        result.frameMs.append(frame([this, base, i] {
+            const int period = 20;
+            const int phase = i % period;
+            const qreal t = phase < period / 2 ? phase / (period / 2.0) : (period - phase) / (period / 2.0);
+            m_window.resize(qRound(base.width() * (1.0 - 0.4 * t)), base.height());
+        }));
+    }
+
+    m_window.resize(base);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("stress_qmaterialwidget"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("QMaterialWidget stress test"));
+    parser.addHelpOption();
+
+    const QCommandLineOption cardsOption(QStringLiteral("cards"), QStringLiteral("Number of cards."), QStringLiteral("n"), QStringLiteral("1000"));
+    const QCommandLineOption columnsOption(QStringLiteral("columns"), QStringLiteral("Cards per row."), QStringLiteral("n"), QStringLiteral("4"));
+    const QCommandLineOption framesOption(QStringLiteral("frames"), QStringLiteral("Frames per phase."), QStringLiteral("n"), QStringLiteral("120"));
+    const QCommandLineOption cardSizeOption(QStringLiteral("card-size"), QStringLiteral("Card size, WxH."), QStringLiteral("size"), QStringLiteral("280x120"));
+    const QCommandLineOption windowSizeOption(QStringLiteral("window-size"), QStringLiteral("Window size, WxH."), QStringLiteral("size"), QStringLiteral("1280x800"));
+    const QCommandLineOption surfaceOption(QStringLiteral("surface"), QStringLiteral("Host cards in a QMaterialSurface."));
+    const QCommandLineOption layerOption(QStringLiteral("layer"), QStringLiteral("Enable the card content layer."));
+    const QCommandLineOption autoMarginsOption(QStringLiteral("auto-margins"), QStringLiteral("Enable automatic shadow margins."));
+    const QCommandLineOption ninePatchOption(QStringLiteral("nine-patch"), QStringLiteral("Use nine-patch shadows."));
+    const QCommandLineOption analyticOption(QStringLiteral("analytic"), QStringLiteral("Use the analytic shadow engine."));
+    const QCommandLineOption outputOption(QStringLiteral("output"), QStringLiteral("Write the JSON report to a file instead of stdout."), QStringLiteral("file"));
+    const QCommandLineOption minFpsOption(QStringLiteral("min-fps"), QStringLiteral("Fail if overall FPS is lower."), QStringLiteral("fps"));
+    const QCommandLineOption maxP99Option(QStringLiteral("max-p99"), QStringLiteral("Fail if overall p99 frame time is higher, in ms."), QStringLiteral("ms"));
+    const QCommandLineOption maxRssOption(QStringLiteral("max-rss"), QStringLiteral("Fail if peak RSS is higher, in MiB."), QStringLiteral("mib"));
+
+    parser.addOptions({cardsOption, columnsOption, framesOption, cardSizeOption, windowSizeOption,
+                       surfaceOption, layerOption, autoMarginsOption, ninePatchOption, analyticOption,
+                       outputOption, minFpsOption, maxP99Option, maxRssOption});
+    parser.process(app);
+
+    Options options;
+    options.cards = qMax(1, parser.value(cardsOption).toInt());
+    options.columns = qMax(1, parser.value(columnsOption).toInt());
+    options.frames = qMax(1, parser.value(framesOption).toInt());
+    options.cardSize = parseSize(parser.value(cardSizeOption), options.cardSize);
+    options.windowSize = parseSize(parser.value(windowSizeOption), options.windowSize);
+    options.surface = parser.isSet(surfaceOption);
+    options.layer = parser.isSet(layerOption);
+    options.autoMargins = parser.isSet(autoMarginsOption);
+    if (parser.isSet(ninePatchOption))
+        options.shadowMode = QMaterialWidget::NinePatchShadow;
+    if (parser.isSet(analyticOption))
+        options.shadowEngine = QMaterialWidget::AnalyticShadowEngine;
+    options.output = parser.value(outputOption);
+    options.minFps = parser.value(minFpsOption).toDouble();
+    options.maxP99Ms = parser.value(maxP99Option).toDouble();
+    options.maxRssMb = parser.value(maxRssOption).toDouble();
+
+    // Кадры задаёт только тест: таймер драйвера не должен вмешиваться
+    QMaterialAnimationDriver::instance()->setFrameInterval(60 * 60 * 1000);
+
+    const qint64 rssBeforeKb = procStatusKb("VmRSS");
+
+    StressRun run(options);
+    const double constructionMs = run.build();
+    const double firstFrameMs = run.showAndWaitForFirstFrame();
+    const qint64 rssBuiltKb = procStatusKb("VmRSS");
+
+    const QVector<PhaseResult> phases = {run.runHover(), run.runPress(), run.runScroll(), run.runResize()};
+
+    QJsonObject report;
+    QJsonObject config;
+    config.insert(QStringLiteral("cards"), options.cards);
+    config.insert(QStringLiteral("columns"), options.columns);
+    config.insert(QStringLiteral("frames_per_phase"), options.frames);
+    config.insert(QStringLiteral("card_size"), QStringLiteral("%1x%2").arg(options.cardSize.width()).arg(options.cardSize.height()));
+    config.insert(QStringLiteral("window_size"), QStringLiteral("%1x%2").arg(options.windowSize.width()).arg(options.windowSize.height()));
+    config.insert(QStringLiteral("surface"), options.surface);
+    config.insert(QStringLiteral("layer"), options.layer);
+    config.insert(QStringLiteral("auto_margins"), options.autoMargins);
+    config.insert(QStringLiteral("nine_patch"), options.shadowMode == QMaterialWidget::NinePatchShadow);
+    config.insert(QStringLiteral("analytic"), options.shadowEngine == QMaterialWidget::AnalyticShadowEngine);
+    config.insert(QStringLiteral("platform"), QGuiApplication::platformName());
+    config.insert(QStringLiteral("qt_version"), QString::fromLatin1(qVersion()));
+    report.insert(QStringLiteral("config"), config);
+
+    report.insert(QStringLiteral("construction_ms"), constructionMs);
+    report.insert(QStringLiteral("construction_us_per_card"), constructionMs * 1000.0 / options.cards);
+    report.insert(QStringLiteral("first_frame_ms"), firstFrameMs);
+
+    QVector<double> allFrames;
+    QJsonObject phaseReports;
+    for (const PhaseResult &phase : phases) {
+        phaseReports.insert(phase.name, summarize(phase.frameMs));
+        allFrames += phase.frameMs;
+    }
+    report.insert(QStringLiteral("phases"), phaseReports);
+
+    const QJsonObject overall = summarize(allFrames);
+    report.insert(QStringLiteral("overall"), overall);
+
+    // -1 — платформа без /proc
+    const qint64 rssEndKb = procStatusKb("VmRSS");
+    const qint64 rssPeakKb = procStatusKb("VmHWM");
+    QJsonObject memory;
+    memory.insert(QStringLiteral("rss_start_mib"), megabytes(rssBeforeKb));
+    memory.insert(QStringLiteral("rss_built_mib"), megabytes(rssBuiltKb));
+    memory.insert(QStringLiteral("rss_end_mib"), megabytes(rssEndKb));
+    memory.insert(QStringLiteral("rss_peak_mib"), megabytes(rssPeakKb));
+    if (rssBeforeKb >= 0 && rssBuiltKb >= 0)
+        memory.insert(QStringLiteral("rss_kib_per_card"), double(rssBuiltKb - rssBeforeKb) / options.cards);
+    report.insert(QStringLiteral("memory"), memory);
+
+    // Пороги для проверки перед релизом
+    QJsonArray failures;
+    if (options.minFps > 0.0 && overall.value(QStringLiteral("fps")).toDouble() < options.minFps)
+        failures.append(QStringLiteral("fps below %1").arg(options.minFps));
+    if (options.maxP99Ms > 0.0 && overall.value(QStringLiteral("p99_ms")).toDouble() > options.maxP99Ms)
+        failures.append(QStringLiteral("p99 above %1 ms").arg(options.maxP99Ms));
+    if (options.maxRssMb > 0.0 && rssPeakKb >= 0 && megabytes(rssPeakKb) > options.maxRssMb)
+        failures.append(QStringLiteral("peak RSS above %1 MiB").arg(options.maxRssMb));
+    report.insert(QStringLiteral("passed"), failures.isEmpty());
+    report.insert(QStringLiteral("failures"), failures);
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (options.output.isEmpty()) {
+        QTextStream(stdout) << json;
+    } else {
+        QFile file(options.output);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "Cannot write " << options.output << '\n';
+            return 2;
+        }
+        file.write(json);
+
+        QTextStream(stdout) << "fps " << overall.value(QStringLiteral("fps")).toDouble()
+                            << ", p99 " << overall.value(QStringLiteral("p99_ms")).toDouble() << " ms"
+                            << ", peak RSS " << megabytes(rssPeakKb) << " MiB"
+                            << ", construction " << constructionMs << " ms\n";
+    }
+
+    for (const QJsonValue &failure : std::as_const(failures))
+        QTextStream(stderr) << "FAILED: " << failure.toString() << '\n';
+
+    return failures.isEmpty() ? 0 : 1;
+}